@@ -0,0 +1,132 @@
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "rp_heap.h"
+#include "pool_allocator.h"
+#include "thread_caching_allocator.h"
+
+static int max_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+// same footprint as an rp_heap<int> node: value, three links, rank
+struct Node {
+    void* links[3];
+    int rank;
+    int value;
+};
+
+static const int kBatch = 256;
+
+// ---------- thread-local churn: every thread allocates and frees its own ----------
+
+// pool_allocator is not thread-safe, so each thread gets its own instance
+template <class Alloc>
+static void BM_LocalChurn(benchmark::State& state) {
+    Alloc alloc;
+    std::vector<Node*> ptrs(kBatch);
+    for (auto _ : state) {
+        for (int i = 0; i < kBatch; i++)
+            ptrs[i] = alloc.allocate(1);
+        benchmark::DoNotOptimize(ptrs.data());
+        for (int i = 0; i < kBatch; i++)
+            alloc.deallocate(ptrs[i], 1);
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK_TEMPLATE(BM_LocalChurn, std::allocator<Node>)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LocalChurn, pool_allocator<Node>)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LocalChurn, thread_caching_allocator<Node>)->ThreadRange(1, max_threads())->UseRealTime();
+
+template <class Alloc>
+static void BM_HeapPushPop(benchmark::State& state) {
+    rp_heap<int, std::less<int>, Alloc> heap;
+    std::mt19937 rng(state.thread_index() + 1);
+    std::vector<int> data(kBatch);
+    for (int& v : data)
+        v = static_cast<int>(rng());
+    for (auto _ : state) {
+        for (int v : data)
+            heap.push(v);
+        int x;
+        for (int i = 0; i < kBatch; i++)
+            heap.pop(x);
+        benchmark::DoNotOptimize(x);
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch * 2);
+}
+BENCHMARK_TEMPLATE(BM_HeapPushPop, std::allocator<int>)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HeapPushPop, pool_allocator<int>)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HeapPushPop, thread_caching_allocator<int>)->ThreadRange(1, max_threads())->UseRealTime();
+
+// ---------- producer/consumer: thread 0 allocates, thread 1 frees ----------
+
+// Allocation front-ends sharing one allocator between the two threads.
+template <class Alloc>
+struct SharedAlloc {
+    static Alloc& get() {
+        static Alloc alloc;
+        return alloc;
+    }
+    static Node* allocate() { return get().allocate(1); }
+    static void deallocate(Node* p) { get().deallocate(p, 1); }
+};
+
+// the only way to share a pool_allocator today: one pool behind a mutex
+struct LockedPool {
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+    static Node* allocate() {
+        std::lock_guard<std::mutex> lock(mutex());
+        return SharedAlloc<pool_allocator<Node>>::allocate();
+    }
+    static void deallocate(Node* p) {
+        std::lock_guard<std::mutex> lock(mutex());
+        SharedAlloc<pool_allocator<Node>>::deallocate(p);
+    }
+};
+
+static std::mutex g_handoff_mutex;
+static std::vector<std::vector<Node*>> g_handoff;
+
+template <class Front>
+static void BM_ProducerConsumer(benchmark::State& state) {
+    std::vector<Node*> batch;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            batch.resize(kBatch);
+            for (int i = 0; i < kBatch; i++)
+                batch[i] = Front::allocate();
+            std::lock_guard<std::mutex> lock(g_handoff_mutex);
+            g_handoff.push_back(std::move(batch));
+            batch.clear();
+        } else {
+            // both threads run the same number of iterations, so a batch
+            // always arrives eventually
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(g_handoff_mutex);
+                    if (!g_handoff.empty()) {
+                        batch = std::move(g_handoff.back());
+                        g_handoff.pop_back();
+                        break;
+                    }
+                }
+                std::this_thread::yield();
+            }
+            for (Node* p : batch)
+                Front::deallocate(p);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, SharedAlloc<std::allocator<Node>>)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, LockedPool)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, SharedAlloc<thread_caching_allocator<Node>>)->Threads(2)->UseRealTime();
@@ -0,0 +1,364 @@
+// Grid A* over scenario files: per-query latency percentiles and expansions
+// per second.
+//
+//   bench_astar [--map=maze512-1-0.map --scen=maze512-1-0.map.scen]
+//               [--queries=N] [--write-scen=out.scen] [benchmark flags]
+//
+// --map takes a Moving AI .map file or the example's .bin format (by
+// extension); --scen a Moving AI .scen file. Without --scen, N queries
+// (default 2000) are generated on the map. Without --map the suite runs on
+// the example map and on a generated 512 x 512 map, so it works offline.
+// --write-scen saves the generated queries of the first map for reuse.
+//
+// Each map runs four ways: /engine reuses one GridAStar for every query,
+// /tiled the same engine over the bit-packed TiledGrid of tiled_map.h,
+// /indexed calls shortest_path_a_star (indexed_rp_heap over cell ids, flat
+// per-cell arrays allocated per query), and /hashed is the earlier search
+// kept below as the baseline (unordered_map open/closed sets, keyed_rp_heap
+// of AstarNode*). allocs_per_query counts global operator new calls.
+//
+// BM_AStar_Batch/<map>/threads:N answers all queries of the map as one batch
+// through BatchAStar with N workers, for N = 1, 2, 4, ... up to the number of
+// hardware threads (--max-threads=N to override), and reports the
+// queries_per_second the pool sustains.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "astar.h"
+#include "astar_batch.h"
+#include "tiled_map.h"
+#include "keyed_rp_heap.h"
+
+#ifndef ASTAR_EXAMPLE_MAP
+#define ASTAR_EXAMPLE_MAP "map/102_000_00033.bin"
+#endif
+
+// ---------- global allocation counter ----------
+
+// atomic because the batch benchmark allocates from its worker threads
+static std::atomic<std::size_t> g_global_allocs{0};
+
+// Every form of new and delete is replaced, so all of them count and free
+// through one pair. That pair stays out of line: inlined into a caller, GCC
+// sees malloc() or free() on the far side of a new/delete and warns.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size) {
+    g_global_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+BENCH_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+// ---------- baseline: hash-map open and closed sets ----------
+
+struct f_score {
+    double operator()(const AstarNode *node) const {
+        return node->f;
+    }
+};
+
+typedef keyed_rp_heap<AstarNode *, f_score> open_heap;
+
+static std::deque<Node> shortest_path_a_star_hashed(const grid_map &map, int L, int W, const Node &s, const Node &g,
+                                                    astar_stats *stats) {
+    typedef open_heap::const_iterator iterator;
+    std::unordered_map<Point2D, iterator, Point2DHash> open_set, closed_set;
+    open_heap heap;
+    std::deque<Node> result_path;
+    std::deque<AstarNode> node_list;
+    astar_stats local;
+
+    node_list.emplace_back(s.x, s.y, 0, heuristic(s.x, s.y, g.x, g.y));
+    open_set[s] = heap.push(&node_list.back());
+
+    const int DIRECTIONS = 8;
+    const int dx[DIRECTIONS] = {0, 1, 0, -1, -1, 1, 1, -1};
+    const int dy[DIRECTIONS] = {-1, 0, 1, 0, -1, -1, 1, 1};
+
+    while (!open_set.empty()) {
+        AstarNode *current_node;
+        heap.pop(current_node);
+        local.expansions++;
+
+        if (*current_node == g) {
+            local.cost = current_node->g;
+            Node *curr = current_node;
+            while (curr) {
+                result_path.push_front(*curr);
+                curr = curr->prev;
+            }
+            heap.clear();
+            break;
+        }
+
+        closed_set[*current_node] = open_set[*current_node];
+        open_set.erase(*current_node);
+
+        for (int i = 0; i < DIRECTIONS; ++i) {
+            int next_x = current_node->x + dx[i];
+            int next_y = current_node->y + dy[i];
+            Point2D neighbor_point(next_x, next_y);
+
+            if (next_y >= 0 && next_y < W && next_x >= 0 && next_x < L && map[next_y][next_x] == 0) {
+                /*
+                 *if the current move being checked is a diagonal one, and there is an obstacle in the path of the diagonal move,
+                 then continue
+                 */
+                if ((dx[i] & dy[i]) && (map[next_y][current_node->x] == 1 || map[current_node->y][next_x] == 1)) {
+                    continue;
+                }
+                if (closed_set.find(neighbor_point) != closed_set.end()) {
+                    continue;
+                }
+
+                double g_score = current_node->g + ((dx[i] & dy[i]) == 0 ? 1 : SQRT2);
+
+                if (open_set.find(neighbor_point) != open_set.end()) {
+                    AstarNode *neighbor = *open_set[neighbor_point];
+                    if (g_score < neighbor->g) {
+                        neighbor->prev = current_node;
+                        neighbor->g = g_score;
+                        neighbor->f = g_score + neighbor->h;
+                        heap.decrease(open_set[neighbor_point], neighbor->f);
+                    }
+                } else {
+                    node_list.emplace_back(next_x, next_y, g_score, heuristic(next_x, next_y, g.x, g.y), current_node);
+                    open_set[neighbor_point] = heap.push(&node_list.back());
+                }
+            }
+        }
+    }
+    if (stats)
+        *stats = local;
+    return result_path;
+}
+
+using astar_solver = std::deque<Node> (*)(const grid_map&, int, int, const Node&, const Node&, astar_stats*);
+
+struct map_case {
+    std::string name;
+    grid_map map;
+    int L = 0, W = 0;
+    std::vector<scenario> queries;
+};
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    std::size_t i = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+// Runs every query of the map once per iteration through query(sc, stats)
+// and reports latency percentiles of the last pass and throughput.
+template <class Query>
+static void RunScenarios(benchmark::State& state, const map_case* mc, Query query) {
+    std::vector<double> latency_us(mc->queries.size());
+    std::size_t expansions = 0, suboptimal = 0, allocs = 0;
+    for (auto _ : state) {
+        expansions = 0;
+        suboptimal = 0;
+        std::size_t allocs_before = g_global_allocs;
+        for (std::size_t q = 0; q < mc->queries.size(); ++q) {
+            const scenario& sc = mc->queries[q];
+            astar_stats stats;
+            auto t0 = std::chrono::steady_clock::now();
+            query(sc, stats);
+            auto t1 = std::chrono::steady_clock::now();
+            latency_us[q] = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            expansions += stats.expansions;
+            if (sc.optimal >= 0 && stats.cost > sc.optimal + 1e-3)
+                suboptimal++;
+        }
+        allocs = g_global_allocs - allocs_before;
+    }
+    // percentiles are over the queries of the last pass
+    std::sort(latency_us.begin(), latency_us.end());
+    const double queries = static_cast<double>(mc->queries.size());
+    state.counters["queries"] = queries;
+    state.counters["p50_us"] = percentile(latency_us, 0.50);
+    state.counters["p90_us"] = percentile(latency_us, 0.90);
+    state.counters["p99_us"] = percentile(latency_us, 0.99);
+    state.counters["max_us"] = latency_us.empty() ? 0 : latency_us.back();
+    state.counters["expansions_per_second"] = benchmark::Counter(
+        static_cast<double>(expansions) * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["queries_per_second"] = benchmark::Counter(
+        queries * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["allocs_per_query"] = queries ? allocs / queries : 0;
+    // the example's Manhattan heuristic is not admissible for 8-connected
+    // moves, so this counts queries longer than the scenario's optimum
+    state.counters["suboptimal"] = static_cast<double>(suboptimal);
+}
+
+static void BM_AStar_Scenarios(benchmark::State& state, const map_case* mc, astar_solver solve) {
+    RunScenarios(state, mc, [&](const scenario& sc, astar_stats& stats) {
+        auto path = solve(mc->map, mc->L, mc->W, Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y), &stats);
+        benchmark::DoNotOptimize(path);
+    });
+}
+
+// one engine and one path buffer for all queries; the warm-up pass sizes
+// the path buffer so the timed passes allocate nothing
+template <class Map>
+static void BM_AStar_Engine(benchmark::State& state, const map_case* mc) {
+    BasicGridAStar<Map> engine(mc->map, mc->L, mc->W);
+    std::vector<Node> path;
+    for (const scenario& sc : mc->queries)
+        engine.search(sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, path);
+    RunScenarios(state, mc, [&](const scenario& sc, astar_stats& stats) {
+        engine.search(sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, path, &stats);
+        benchmark::DoNotOptimize(path.data());
+    });
+}
+
+// all queries of the map as one batch per iteration; the warm-up batch
+// sizes the result buffers, which every later batch reuses
+static void BM_AStar_Batch(benchmark::State& state, const map_case* mc) {
+    BatchAStar batch(mc->map, mc->L, mc->W, static_cast<unsigned>(state.range(0)));
+    std::vector<path_query> queries;
+    for (const scenario& sc : mc->queries)
+        queries.emplace_back(Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y));
+    std::vector<path_result> results;
+    batch.run(queries, results);
+    std::size_t expansions = 0, allocs = 0;
+    for (auto _ : state) {
+        std::size_t allocs_before = g_global_allocs;
+        batch.run(queries, results);
+        allocs = g_global_allocs - allocs_before;
+        benchmark::DoNotOptimize(results.data());
+    }
+    for (const path_result& r : results)
+        expansions += r.stats.expansions;
+    const double count = static_cast<double>(queries.size());
+    state.counters["queries"] = count;
+    state.counters["expansions_per_second"] = benchmark::Counter(
+        static_cast<double>(expansions) * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["queries_per_second"] = benchmark::Counter(
+        count * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["allocs_per_query"] = count ? allocs / count : 0;
+}
+
+static bool ends_with(const std::string& s, const char* suffix) {
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::string map_path, scen_path, write_path;
+    std::size_t query_count = 2000;
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--map=", 6) == 0)
+            map_path = argv[i] + 6;
+        else if (std::strncmp(argv[i], "--scen=", 7) == 0)
+            scen_path = argv[i] + 7;
+        else if (std::strncmp(argv[i], "--queries=", 10) == 0)
+            query_count = std::strtoul(argv[i] + 10, nullptr, 10);
+        else if (std::strncmp(argv[i], "--write-scen=", 13) == 0)
+            write_path = argv[i] + 13;
+        else if (std::strncmp(argv[i], "--max-threads=", 14) == 0)
+            max_threads = std::max(1ul, std::strtoul(argv[i] + 14, nullptr, 10));
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+
+    std::vector<map_case> cases;
+    if (!map_path.empty()) {
+        map_case mc;
+        mc.name = map_path.substr(map_path.find_last_of("/\\") + 1);
+        bool ok = ends_with(map_path, ".bin") ? load_bin_map(map_path, mc.map, mc.L, mc.W)
+                                              : load_movingai_map(map_path, mc.map, mc.L, mc.W);
+        if (!ok) {
+            std::fprintf(stderr, "cannot read map %s\n", map_path.c_str());
+            return 1;
+        }
+        cases.push_back(std::move(mc));
+    } else {
+        map_case example;
+        example.name = "102_000_00033";
+        if (load_bin_map(ASTAR_EXAMPLE_MAP, example.map, example.L, example.W))
+            cases.push_back(std::move(example));
+        else
+            std::fprintf(stderr, "example map %s not found, skipping it\n", ASTAR_EXAMPLE_MAP);
+        map_case random;
+        random.name = "random512_d25";
+        random.L = random.W = 512;
+        random.map = make_random_map(512, 512, 0.25, 1);
+        cases.push_back(std::move(random));
+    }
+
+    for (std::size_t c = 0; c < cases.size(); ++c) {
+        map_case& mc = cases[c];
+        if (!scen_path.empty() && c == 0) {
+            if (!load_scenarios(scen_path, mc.queries)) {
+                std::fprintf(stderr, "cannot read scenarios %s\n", scen_path.c_str());
+                return 1;
+            }
+        } else {
+            mc.queries = generate_scenarios(mc.map, mc.L, mc.W, query_count, 7);
+        }
+        if (!write_path.empty() && c == 0) {
+            std::ofstream out(write_path);
+            write_scenarios(out, mc.name, mc.L, mc.W, mc.queries);
+        }
+        benchmark::RegisterBenchmark(("BM_AStar_Scenarios/" + mc.name + "/engine").c_str(),
+                                     BM_AStar_Engine<FlatGrid>, &mc)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_AStar_Scenarios/" + mc.name + "/tiled").c_str(),
+                                     BM_AStar_Engine<TiledGrid>, &mc)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_AStar_Scenarios/" + mc.name + "/indexed").c_str(), BM_AStar_Scenarios, &mc,
+                                     &shortest_path_a_star)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_AStar_Scenarios/" + mc.name + "/hashed").c_str(), BM_AStar_Scenarios, &mc,
+                                     &shortest_path_a_star_hashed)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_AStar_Batch/" + mc.name).c_str(), BM_AStar_Batch, &mc)
+            ->ArgName("threads")->RangeMultiplier(2)->Range(1, max_threads)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "rp_heap.h"
+#include "concurrent_rp_heap.h"
+
+static std::vector<int> make_random_ints(int n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> v(n);
+    for (int i = 0; i < n; i++)
+        v[i] = rng();
+    return v;
+}
+
+static int max_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+// ---------- throughput: one push + one pop per item per thread ----------
+
+static const int kPrefill = 100000;
+static const int kOpsPerIteration = 1000;
+
+static concurrent_rp_heap<int>* g_multiqueue = nullptr;
+
+static void BM_MultiQueue_Throughput(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        // 4 shards per thread, as in the MultiQueue paper's c = 4 setting
+        g_multiqueue = new concurrent_rp_heap<int>(4 * state.threads());
+        for (int v : make_random_ints(kPrefill, 1))
+            g_multiqueue->push(v);
+    }
+    auto data = make_random_ints(kOpsPerIteration, 100 + state.thread_index());
+    for (auto _ : state) {
+        int x;
+        for (int i = 0; i < kOpsPerIteration; i++) {
+            g_multiqueue->push(data[i]);
+            benchmark::DoNotOptimize(g_multiqueue->try_pop(x));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kOpsPerIteration * 2);
+    if (state.thread_index() == 0) {
+        delete g_multiqueue;
+        g_multiqueue = nullptr;
+    }
+}
+BENCHMARK(BM_MultiQueue_Throughput)->ThreadRange(1, max_threads())->UseRealTime();
+
+// baseline: a single rp_heap behind one global mutex
+static rp_heap<int>* g_locked_heap = nullptr;
+static std::mutex g_heap_mutex;
+
+static void BM_LockedHeap_Throughput(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_locked_heap = new rp_heap<int>();
+        for (int v : make_random_ints(kPrefill, 1))
+            g_locked_heap->push(v);
+    }
+    auto data = make_random_ints(kOpsPerIteration, 100 + state.thread_index());
+    for (auto _ : state) {
+        int x;
+        for (int i = 0; i < kOpsPerIteration; i++) {
+            std::lock_guard<std::mutex> lock(g_heap_mutex);
+            g_locked_heap->push(data[i]);
+            g_locked_heap->pop(x);
+            benchmark::DoNotOptimize(x);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kOpsPerIteration * 2);
+    if (state.thread_index() == 0) {
+        delete g_locked_heap;
+        g_locked_heap = nullptr;
+    }
+}
+BENCHMARK(BM_LockedHeap_Throughput)->ThreadRange(1, max_threads())->UseRealTime();
+
+// ---------- quality: rank error of relaxed pops ----------
+
+// Fenwick tree over keys 0..n-1 counting the keys still in the queue, so the
+// rank of a popped key among the remaining ones is a prefix sum.
+class RankCounter {
+public:
+    explicit RankCounter(int n) : tree_(n + 1, 0) {
+        for (int i = 0; i < n; i++)
+            add(i, 1);
+    }
+    void add(int key, int delta) {
+        for (int i = key + 1; i < static_cast<int>(tree_.size()); i += i & -i)
+            tree_[i] += delta;
+    }
+    int count_below(int key) const {
+        int sum = 0;
+        for (int i = key; i > 0; i -= i & -i)
+            sum += tree_[i];
+        return sum;
+    }
+private:
+    std::vector<int> tree_;
+};
+
+// Pops a shuffled permutation of 0..n-1 from a queue with range(0) shards
+// and reports the mean and max number of smaller keys still queued at each
+// pop (0 for an exact priority queue).
+static void BM_MultiQueue_RankError(benchmark::State& state) {
+    const int shards = static_cast<int>(state.range(0));
+    const int n = 100000;
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; i++)
+        keys[i] = i;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+
+    double mean_error = 0, max_error = 0;
+    for (auto _ : state) {
+        concurrent_rp_heap<int> queue(shards);
+        for (int k : keys)
+            queue.push(k);
+        RankCounter remaining(n);
+        long long total = 0;
+        int worst = 0, x;
+        while (queue.try_pop(x)) {
+            int rank = remaining.count_below(x);
+            total += rank;
+            worst = std::max(worst, rank);
+            remaining.add(x, -1);
+        }
+        mean_error = static_cast<double>(total) / n;
+        max_error = worst;
+    }
+    state.counters["mean_rank_error"] = mean_error;
+    state.counters["max_rank_error"] = max_error;
+}
+BENCHMARK(BM_MultiQueue_RankError)->RangeMultiplier(2)->Range(1, 64)->Unit(benchmark::kMillisecond);
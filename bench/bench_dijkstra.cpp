@@ -0,0 +1,332 @@
+// Dijkstra on road-like graphs with different priority queues.
+//
+//   bench_dijkstra [--graph=path/to/USA-road-d.NY.gr ...] [benchmark flags]
+//
+// Without --graph only the synthetic graphs are run, so the suite works
+// offline. Each benchmark reports settled pops, decrease-keys, stale pops
+// (lazy-deletion queue only) and the peak heap memory of one run.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "csr_graph.h"
+#include "monotone_heap.h"
+#include "pool_allocator.h"
+#include "rp_heap.h"
+#include "sssp.h"
+
+// ---------- peak memory through the global allocator ----------
+
+static std::size_t g_live_bytes = 0;
+static std::size_t g_peak_bytes = 0;
+
+// Every form of new and delete is replaced, so all of them are measured and
+// free through one pair. Each block carries its size in a 16-byte prefix so
+// delete can subtract it. The pair stays out of line: inlined into a caller,
+// GCC sees malloc() or free() on the far side of a new/delete and warns.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size) {
+    void* raw = std::malloc(size + 16);
+    if (!raw)
+        throw std::bad_alloc();
+    *static_cast<std::size_t*>(raw) = size;
+    g_live_bytes += size;
+    g_peak_bytes = std::max(g_peak_bytes, g_live_bytes);
+    return static_cast<char*>(raw) + 16;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+BENCH_NOINLINE void operator delete(void* p) noexcept {
+    if (!p)
+        return;
+    void* raw = static_cast<char*>(p) - 16;
+    g_live_bytes -= *static_cast<std::size_t*>(raw);
+    std::free(raw);
+}
+
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+struct run_counts {
+    std::size_t pops = 0;       // vertices settled
+    std::size_t decreases = 0;  // decrease-key calls
+    std::size_t stale = 0;      // out-of-date entries skipped
+};
+
+using vertex = csr_graph::vertex_type;
+
+// ---------- queues ----------
+
+// one node per vertex and decrease-key through its handle; Heap is an
+// rp_heap or a monotone_heap keyed by by_distance
+template <class Heap>
+static std::vector<distance_type> dijkstra_handles(const csr_graph& g, vertex source, run_counts& c) {
+    using heap_type = Heap;
+    const vertex n = g.num_vertices();
+    std::vector<distance_type> dist(n, unreachable);
+    std::vector<typename heap_type::const_iterator> handle(n);
+    std::vector<char> state(n, 0);
+    heap_type heap(by_distance{dist.data()});
+    dist[source] = 0;
+    handle[source] = heap.push(source);
+    state[source] = 1;
+    while (!heap.empty()) {
+        vertex u;
+        heap.pop(u);
+        state[u] = 2;
+        c.pops++;
+        for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            vertex v = g.targets[e];
+            distance_type nd = dist[u] + g.weights[e];
+            if (state[v] == 2 || nd >= dist[v])
+                continue;
+            dist[v] = nd;
+            if (state[v] == 1) {
+                heap.decrease(handle[v], v);
+                c.decreases++;
+            } else {
+                handle[v] = heap.push(v);
+                state[v] = 1;
+            }
+        }
+    }
+    return dist;
+}
+
+// std::priority_queue without decrease-key: push a new entry on every
+// improvement and skip entries whose distance is out of date
+static std::vector<distance_type> dijkstra_lazy(const csr_graph& g, vertex source, run_counts& c) {
+    using entry = std::pair<distance_type, vertex>;
+    std::vector<distance_type> dist(g.num_vertices(), unreachable);
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+    dist[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty()) {
+        entry top = queue.top();
+        queue.pop();
+        if (top.first != dist[top.second]) {
+            c.stale++;
+            continue;
+        }
+        c.pops++;
+        vertex u = top.second;
+        for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            vertex v = g.targets[e];
+            distance_type nd = top.first + g.weights[e];
+            if (nd < dist[v]) {
+                c.decreases += dist[v] != unreachable;
+                dist[v] = nd;
+                queue.push({nd, v});
+            }
+        }
+    }
+    return dist;
+}
+
+// implicit d-ary heap of vertex ids with a position index for decrease-key
+template <unsigned D>
+class dary_heap {
+public:
+    dary_heap(const distance_type* dist, vertex n) : dist_(dist), pos_(n, npos) {}
+
+    bool empty() const { return heap_.empty(); }
+    bool contains(vertex v) const { return pos_[v] != npos; }
+
+    void push(vertex v) {
+        heap_.push_back(v);
+        sift_up(heap_.size() - 1);
+    }
+
+    // dist[v] was lowered by the caller
+    void decrease(vertex v) { sift_up(pos_[v]); }
+
+    vertex pop() {
+        vertex top = heap_.front();
+        pos_[top] = npos;
+        vertex last = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty()) {
+            heap_[0] = last;
+            pos_[last] = 0;
+            sift_down(0);
+        }
+        return top;
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    void place(std::size_t i, vertex v) {
+        heap_[i] = v;
+        pos_[v] = i;
+    }
+
+    void sift_up(std::size_t i) {
+        vertex v = heap_[i];
+        while (i > 0) {
+            std::size_t parent = (i - 1) / D;
+            if (dist_[heap_[parent]] <= dist_[v])
+                break;
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, v);
+    }
+
+    void sift_down(std::size_t i) {
+        vertex v = heap_[i];
+        for (;;) {
+            std::size_t first = i * D + 1;
+            if (first >= heap_.size())
+                break;
+            std::size_t best = first;
+            std::size_t last = std::min(first + D, heap_.size());
+            for (std::size_t k = first + 1; k < last; ++k)
+                if (dist_[heap_[k]] < dist_[heap_[best]])
+                    best = k;
+            if (dist_[heap_[best]] >= dist_[v])
+                break;
+            place(i, heap_[best]);
+            i = best;
+        }
+        place(i, v);
+    }
+
+    const distance_type* dist_;
+    std::vector<vertex> heap_;
+    std::vector<std::size_t> pos_;
+};
+
+static std::vector<distance_type> dijkstra_dary(const csr_graph& g, vertex source, run_counts& c) {
+    std::vector<distance_type> dist(g.num_vertices(), unreachable);
+    std::vector<char> settled(g.num_vertices(), 0);
+    dary_heap<4> heap(dist.data(), g.num_vertices());
+    dist[source] = 0;
+    heap.push(source);
+    while (!heap.empty()) {
+        vertex u = heap.pop();
+        settled[u] = 1;
+        c.pops++;
+        for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            vertex v = g.targets[e];
+            distance_type nd = dist[u] + g.weights[e];
+            if (settled[v] || nd >= dist[v])
+                continue;
+            dist[v] = nd;
+            if (heap.contains(v)) {
+                heap.decrease(v);
+                c.decreases++;
+            } else
+                heap.push(v);
+        }
+    }
+    return dist;
+}
+
+// ---------- registration ----------
+
+using solver = std::vector<distance_type> (*)(const csr_graph&, vertex, run_counts&);
+
+struct named_graph {
+    std::string name;
+    csr_graph graph;
+};
+
+static void run_solver(benchmark::State& state, const csr_graph* g, solver solve) {
+    run_counts counts;
+    std::size_t peak = 0;
+    for (auto _ : state) {
+        counts = run_counts();
+        std::size_t before = g_live_bytes;
+        g_peak_bytes = before;
+        benchmark::DoNotOptimize(solve(*g, 0, counts));
+        peak = g_peak_bytes - before;
+    }
+    state.counters["pops"] = static_cast<double>(counts.pops);
+    state.counters["decreases"] = static_cast<double>(counts.decreases);
+    state.counters["stale_pops"] = static_cast<double>(counts.stale);
+    state.counters["peak_bytes"] = benchmark::Counter(static_cast<double>(peak),
+        benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+    state.counters["edges_per_second"] = benchmark::Counter(
+        static_cast<double>(g->num_edges()) * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+int main(int argc, char** argv) {
+    std::vector<named_graph> graphs;
+    graphs.push_back({"road_1024x1024", make_road_graph(1024, 1024, 1)});
+    graphs.push_back({"random_1M_deg4", make_random_graph(1000000, 4, 1000, 1)});
+
+    // strip our own --graph= flags before Google Benchmark sees argv
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--graph=", 8) == 0) {
+            std::string path = argv[i] + 8;
+            try {
+                graphs.push_back({path.substr(path.find_last_of("/\\") + 1), load_dimacs_gr(path)});
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "%s\n", e.what());
+                return 1;
+            }
+        } else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+
+    const std::pair<const char*, solver> solvers[] = {
+        {"rp_heap", &dijkstra_handles<rp_heap<vertex, by_distance>>},
+        {"rp_heap_pool", &dijkstra_handles<rp_heap<vertex, by_distance, pool_allocator<vertex>>>},
+        {"monotone_heap", &dijkstra_handles<monotone_heap<vertex, by_distance>>},
+        {"monotone_heap_pool", &dijkstra_handles<monotone_heap<vertex, by_distance, pool_allocator<vertex>>>},
+        {"std_pq_lazy", &dijkstra_lazy},
+        {"dary4", &dijkstra_dary},
+    };
+    for (const named_graph& ng : graphs) {
+        // every queue must agree before anything is timed
+        run_counts unused;
+        std::vector<distance_type> expected = dijkstra_handles<rp_heap<vertex, by_distance>>(ng.graph, 0, unused);
+        for (const auto& s : solvers) {
+            run_counts c;
+            if (s.second(ng.graph, 0, c) != expected) {
+                std::fprintf(stderr, "%s disagrees on %s\n", s.first, ng.name.c_str());
+                return 1;
+            }
+            benchmark::RegisterBenchmark(("BM_Dijkstra/" + ng.name + "/" + s.first).c_str(),
+                                         run_solver, &ng.graph, s.second)
+                ->Unit(benchmark::kMillisecond)->UseRealTime();
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
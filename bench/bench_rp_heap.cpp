@@ -1,11 +1,63 @@
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <memory>
+#include <new>
 #include <queue>
 #include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include <benchmark/benchmark.h>
 #include "rp_heap.h"
 #include "pool_allocator.h"
+#include "mmap_arena.h"
+#include "compact_rp_heap.h"
+#include "keyed_rp_heap.h"
+#include "intrusive_rp_heap.h"
+
+// ---------- global allocation counter ----------
+
+static std::size_t g_global_allocs = 0;
+
+// Every form of new and delete is replaced, so all of them count and free
+// through one pair. That pair stays out of line: inlined into a caller, GCC
+// sees malloc() or free() on the far side of a new/delete and warns.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size) {
+    ++g_global_allocs;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+BENCH_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
 
 static std::vector<int> make_random_ints(int n) {
     std::mt19937 rng(42);
@@ -15,104 +67,437 @@ static std::vector<int> make_random_ints(int n) {
     return v;
 }
 
+// ---------- operation counters ----------
+
+// Every rp_heap benchmark is a template over the consolidation policy and
+// registered once per policy, as BM_Name<rp_heap_multipass> and
+// BM_Name<rp_heap_one_pass>.
+#define BENCHMARK_PASSES(bm, ...)                        \
+    BENCHMARK_TEMPLATE(bm, rp_heap_multipass)__VA_ARGS__; \
+    BENCHMARK_TEMPLATE(bm, rp_heap_one_pass)__VA_ARGS__
+
+template <class Pass, class T = int, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+using PassHeap = rp_heap<T, Compare, Alloc, rp_heap_no_stats, Pass>;
+
+template <class Pass>
+using CountedHeap = rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats, Pass>;
+
+// Runs the workload once more, outside the timed loop, on a heap that counts
+// its operations and reports the counts as user counters. The counts do not
+// depend on the allocator, so the pool_allocator variants report the same
+// workload on a std::allocator heap. With a setup step, the heap is built by
+// setup and only the workload's operations are counted.
+template <class Pass, class Workload>
+static void AddHeapCounters(benchmark::State& state, Workload workload) {
+    AddHeapCounters<Pass>(state, workload, [](auto&) {});
+}
+
+template <class Pass, class Workload, class Setup>
+static void AddHeapCounters(benchmark::State& state, Workload workload, Setup setup) {
+    CountedHeap<Pass> heap;
+    setup(heap);
+    heap.reset_stats();
+    workload(heap);
+    rp_heap_stats st = heap.stats();
+    state.counters["cmps"] = static_cast<double>(st.comparisons);
+    state.counters["links"] = static_cast<double>(st.links);
+    state.counters["roots/pop"] = st.consolidations
+        ? static_cast<double>(st.roots_scanned) / st.consolidations : 0;
+    state.counters["max_roots"] = static_cast<double>(st.max_roots);
+    state.counters["max_rank"] = st.max_rank;
+    state.counters["rr_steps"] = static_cast<double>(st.rank_reduction_steps);
+}
+
+// Times the workload on a fresh Heap per iteration, then adds the counters.
+template <class Pass, class Heap, class Workload>
+static void RunHeapWorkload(benchmark::State& state, Workload workload) {
+    for (auto _ : state) {
+        Heap heap;
+        workload(heap);
+    }
+    AddHeapCounters<Pass>(state, workload);
+}
+
+// ---------- workloads shared by the allocator variants ----------
+
+static auto push_workload(const std::vector<int>& data) {
+    return [&data](auto& heap) {
+        for (int v : data)
+            heap.push(v);
+        benchmark::DoNotOptimize(heap.top());
+    };
+}
+
+// the same as rp_heap(first, last)
+static auto bulk_build_workload(const std::vector<int>& data) {
+    return [&data](auto& heap) {
+        heap.push_range(data.begin(), data.end());
+        benchmark::DoNotOptimize(heap.top());
+    };
+}
+
+static auto pop_all_workload(const std::vector<int>& data) {
+    return [&data](auto& heap) {
+        for (int v : data)
+            heap.push(v);
+        while (!heap.empty())
+            heap.pop();
+    };
+}
+
+// n pushes to fill the heap, then n push-pop pairs; data holds 2n values
+static auto push_pop_workload(const std::vector<int>& data) {
+    return [&data](auto& heap) {
+        const std::size_t n = data.size() / 2;
+        for (std::size_t i = 0; i < n; i++)
+            heap.push(data[i]);
+        for (std::size_t i = n; i < 2 * n; i++) {
+            heap.push(data[i]);
+            heap.pop();
+        }
+        benchmark::DoNotOptimize(heap.size());
+    };
+}
+
+static auto decrease_workload(const std::vector<int>& data, const std::vector<int>& decrements) {
+    return [&data, &decrements](auto& heap) {
+        std::vector<typename std::decay_t<decltype(heap)>::const_iterator> its;
+        its.reserve(data.size());
+        for (int v : data)
+            its.push_back(heap.push(v));
+        for (std::size_t i = 0; i < data.size(); i++)
+            heap.decrease(its[i], *its[i] - decrements[i]);
+        benchmark::DoNotOptimize(heap.top());
+    };
+}
+
+static std::vector<int> make_decrements(int n) {
+    std::mt19937 rng(123);
+    std::vector<int> decrements(n);
+    for (int i = 0; i < n; i++)
+        decrements[i] = rng() % 1000 + 1;
+    return decrements;
+}
+
 // ---------- rp_heap benchmarks ----------
 
+template <class Pass>
 static void BM_Push(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PassHeap<Pass>>(state, push_workload(data));
+}
+BENCHMARK_PASSES(BM_Push, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// rp_heap(first, last) versus the push loop above and std::make_heap
+template <class Pass>
+static void BM_BulkBuild(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PassHeap<Pass>>(state, bulk_build_workload(data));
+}
+BENCHMARK_PASSES(BM_BulkBuild, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_BulkBuild_Pool(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PassHeap<Pass, int, std::less<int>, pool_allocator<int>>>(state, bulk_build_workload(data));
+}
+BENCHMARK_PASSES(BM_BulkBuild_Pool, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+static void BM_StdMakeHeap(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
     for (auto _ : state) {
-        rp_heap<int> heap;
-        for (int i = 0; i < n; i++)
-            heap.push(data[i]);
-        benchmark::DoNotOptimize(heap.top());
+        std::vector<int> v(data.begin(), data.end());
+        std::make_heap(v.begin(), v.end(), std::greater<int>());
+        benchmark::DoNotOptimize(v.front());
     }
 }
-BENCHMARK(BM_Push)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK(BM_StdMakeHeap)->RangeMultiplier(10)->Range(1000, 1000000);
 
+template <class Pass>
 static void BM_PopAll(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PassHeap<Pass>>(state, pop_all_workload(data));
+}
+BENCHMARK_PASSES(BM_PopAll, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_PushPop(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)) * 2);
+    RunHeapWorkload<Pass, PassHeap<Pass>>(state, push_pop_workload(data));
+}
+BENCHMARK_PASSES(BM_PushPop, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_DecreaseKey(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
-    for (auto _ : state) {
-        rp_heap<int> heap;
+    auto decrements = make_decrements(n);
+    RunHeapWorkload<Pass, PassHeap<Pass>>(state, decrease_workload(data, decrements));
+}
+BENCHMARK_PASSES(BM_DecreaseKey, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// Timer-wheel style workload: n timers are armed, every other one is
+// cancelled before expiry and the rest fire in order. BM_Cancel_Erase
+// removes cancelled timers with erase(); BM_Cancel_Tombstone marks them and
+// skips them on pop, which is what callers had to do without erase().
+template <class Pass>
+static void BM_Cancel_Erase(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    auto workload = [&](auto& heap) {
+        std::vector<typename std::decay_t<decltype(heap)>::const_iterator> its;
+        its.reserve(n);
+        heap.push(INT_MIN); // popped sentinel links the rest into half trees
         for (int i = 0; i < n; i++)
-            heap.push(data[i]);
+            its.push_back(heap.push(data[i]));
+        heap.pop();
+        for (int i = 1; i < n; i += 2)
+            heap.erase(its[i]);
         while (!heap.empty())
             heap.pop();
+    };
+    for (auto _ : state) {
+        PassHeap<Pass> heap;
+        workload(heap);
     }
+    AddHeapCounters<Pass>(state, workload);
 }
-BENCHMARK(BM_PopAll)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_PASSES(BM_Cancel_Erase, ->RangeMultiplier(10)->Range(1000, 1000000));
 
-static void BM_PushPop(benchmark::State& state) {
+template <class Pass>
+static void BM_Cancel_Tombstone(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
-    auto data = make_random_ints(n * 2);
+    auto data = make_random_ints(n);
+    struct Timer {
+        int when;
+        int id;
+        bool operator<(const Timer& other) const { return when < other.when; }
+    };
     for (auto _ : state) {
-        rp_heap<int> heap;
+        PassHeap<Pass, Timer> heap;
+        std::vector<char> cancelled(n, 0);
+        heap.push(Timer{INT_MIN, -1});
         for (int i = 0; i < n; i++)
-            heap.push(data[i]);
-        for (int i = n; i < n * 2; i++) {
-            heap.push(data[i]);
-            heap.pop();
+            heap.push(Timer{data[i], i});
+        heap.pop();
+        for (int i = 1; i < n; i += 2)
+            cancelled[i] = 1;
+        int fired = 0;
+        while (!heap.empty()) {
+            Timer t;
+            heap.pop(t);
+            if (!cancelled[t.id])
+                fired++;
         }
-        benchmark::DoNotOptimize(heap.size());
+        benchmark::DoNotOptimize(fired);
     }
 }
-BENCHMARK(BM_PushPop)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_PASSES(BM_Cancel_Tombstone, ->RangeMultiplier(10)->Range(1000, 1000000));
 
-static void BM_DecreaseKey(benchmark::State& state) {
+template <class Pass>
+static void BM_UpdateIncrease(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
-    std::mt19937 rng(123);
-    std::vector<int> decrements(n);
+    std::mt19937 rng(321);
+    std::vector<int> increments(n);
     for (int i = 0; i < n; i++)
-        decrements[i] = rng() % 1000 + 1;
+        increments[i] = rng() % 1000 + 1;
 
-    for (auto _ : state) {
-        rp_heap<int> heap;
-        std::vector<rp_heap<int>::const_iterator> its;
+    auto workload = [&](auto& heap) {
+        std::vector<typename std::decay_t<decltype(heap)>::const_iterator> its;
         its.reserve(n);
+        heap.push(INT_MIN);
         for (int i = 0; i < n; i++)
-            its.push_back(heap.push(data[i]));
+            its.push_back(heap.push(data[i] / 2));
+        heap.pop();
         for (int i = 0; i < n; i++)
-            heap.decrease(its[i], *its[i] - decrements[i]);
+            heap.update(its[i], *its[i] + increments[i]);
         benchmark::DoNotOptimize(heap.top());
+    };
+    for (auto _ : state) {
+        PassHeap<Pass> heap;
+        workload(heap);
     }
+    AddHeapCounters<Pass>(state, workload);
 }
-BENCHMARK(BM_DecreaseKey)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_PASSES(BM_UpdateIncrease, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// top-k extraction from a heap of n: pop_n(k), which consolidates once for
+// the batch, against k calls of pop(value_type&), and the non-destructive
+// peek_k(k)
+
+// the heap the top-k benchmarks start from, consolidated by one pop
+static auto top_k_setup(const std::vector<int>& data) {
+    return [&data](auto& heap) {
+        heap.push_range(data.begin(), data.end());
+        heap.pop();
+    };
+}
+
+template <class Pass>
+static void BM_PopN(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    const int k = static_cast<int>(state.range(1));
+    auto data = make_random_ints(n);
+    std::vector<int> out(k);
+    std::unique_ptr<PassHeap<Pass>> heap;
+    for (auto _ : state) {
+        state.PauseTiming();
+        // free the old heap before building the new one, whose nodes then
+        // reuse its chunks; freed the other way round they sit in malloc's
+        // fastbins and the first sizeable allocation of the timed region
+        // (pop_n's frontier) pays to coalesce all n of them
+        heap.reset();
+        heap.reset(new PassHeap<Pass>(data.begin(), data.end()));
+        heap->pop(); // consolidate once so both variants start alike
+        state.ResumeTiming();
+        heap->pop_n(k, out.begin());
+        benchmark::DoNotOptimize(out.data());
+    }
+    AddHeapCounters<Pass>(state, [&](auto& h) { h.pop_n(k, out.begin()); }, top_k_setup(data));
+}
+BENCHMARK_PASSES(BM_PopN, ->Args({100000, 10})->Args({100000, 100})->Args({100000, 1000})->Args({1000000, 1000}));
+
+template <class Pass>
+static void BM_PopLoop(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    const int k = static_cast<int>(state.range(1));
+    auto data = make_random_ints(n);
+    std::vector<int> out(k);
+    std::unique_ptr<PassHeap<Pass>> heap;
+    for (auto _ : state) {
+        state.PauseTiming();
+        heap.reset();
+        heap.reset(new PassHeap<Pass>(data.begin(), data.end()));
+        heap->pop();
+        state.ResumeTiming();
+        for (int i = 0; i < k; i++)
+            heap->pop(out[i]);
+        benchmark::DoNotOptimize(out.data());
+    }
+    AddHeapCounters<Pass>(state, [&](auto& h) {
+        for (int i = 0; i < k; i++)
+            h.pop(out[i]);
+    }, top_k_setup(data));
+}
+BENCHMARK_PASSES(BM_PopLoop, ->Args({100000, 10})->Args({100000, 100})->Args({100000, 1000})->Args({1000000, 1000}));
+
+template <class Pass>
+static void BM_PeekK(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    const int k = static_cast<int>(state.range(1));
+    auto data = make_random_ints(n);
+    PassHeap<Pass> heap(data.begin(), data.end());
+    heap.pop();
+    std::vector<int> out(k);
+    for (auto _ : state) {
+        heap.peek_k(k, out.begin());
+        benchmark::DoNotOptimize(out.data());
+    }
+    AddHeapCounters<Pass>(state, [&](auto& h) { h.peek_k(k, out.begin()); }, top_k_setup(data));
+}
+BENCHMARK_PASSES(BM_PeekK, ->Args({100000, 10})->Args({100000, 100})->Args({100000, 1000})->Args({1000000, 1000}));
 
 // ---------- rp_heap + pool_allocator benchmarks ----------
 
-using PoolHeap = rp_heap<int, std::less<int>, pool_allocator<int>>;
+template <class Pass>
+using PoolHeap = PassHeap<Pass, int, std::less<int>, pool_allocator<int>>;
 
+template <class Pass>
 static void BM_Pool_Push(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PoolHeap<Pass>>(state, push_workload(data));
+}
+BENCHMARK_PASSES(BM_Pool_Push, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_Pool_PopAll(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)));
+    RunHeapWorkload<Pass, PoolHeap<Pass>>(state, pop_all_workload(data));
+}
+BENCHMARK_PASSES(BM_Pool_PopAll, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_Pool_PushPop(benchmark::State& state) {
+    auto data = make_random_ints(static_cast<int>(state.range(0)) * 2);
+    RunHeapWorkload<Pass, PoolHeap<Pass>>(state, push_pop_workload(data));
+}
+BENCHMARK_PASSES(BM_Pool_PushPop, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// burst to n nodes, free all but the oldest 1% in random order, then trim()
+static void BM_Pool_TrimAfterBurst(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = n - 1 - i;
+    std::shuffle(order.begin(), order.end() - n / 100, std::mt19937(11));
+    std::vector<long long*> ptrs(n);
+    double released = 0, reserved_after = 0;
+    std::unique_ptr<pool_allocator<long long>> pool;
+    for (auto _ : state) {
+        state.PauseTiming();
+        pool.reset(new pool_allocator<long long>());
+        for (int i = 0; i < n; i++)
+            ptrs[i] = pool->allocate(1);
+        for (int i = 0; i < n - n / 100; i++)
+            pool->deallocate(ptrs[order[i]], 1);
+        state.ResumeTiming();
+        released = static_cast<double>(pool->trim());
+        state.PauseTiming();
+        reserved_after = static_cast<double>(pool->stats().bytes_reserved);
+        for (int i = n - n / 100; i < n; i++)
+            pool->deallocate(ptrs[order[i]], 1);
+        state.ResumeTiming();
+    }
+    state.counters["bytes_released"] = released;
+    state.counters["bytes_reserved_after"] = reserved_after;
+}
+BENCHMARK(BM_Pool_TrimAfterBurst)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond);
+
+template <class Pass>
+static void BM_Pool_DecreaseKey(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    auto decrements = make_decrements(n);
+    RunHeapWorkload<Pass, PoolHeap<Pass>>(state, decrease_workload(data, decrements));
+}
+BENCHMARK_PASSES(BM_Pool_DecreaseKey, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// ---------- compact_rp_heap (32-bit index links) benchmarks ----------
+
+using CompactHeap = compact_rp_heap<int>;
+
+static void BM_Compact_Push(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
     for (auto _ : state) {
-        PoolHeap heap;
+        CompactHeap heap;
         for (int i = 0; i < n; i++)
             heap.push(data[i]);
         benchmark::DoNotOptimize(heap.top());
     }
 }
-BENCHMARK(BM_Pool_Push)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK(BM_Compact_Push)->RangeMultiplier(10)->Range(1000, 10000000);
 
-static void BM_Pool_PopAll(benchmark::State& state) {
+static void BM_Compact_PopAll(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
     for (auto _ : state) {
-        PoolHeap heap;
+        CompactHeap heap;
         for (int i = 0; i < n; i++)
             heap.push(data[i]);
         while (!heap.empty())
             heap.pop();
     }
 }
-BENCHMARK(BM_Pool_PopAll)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK(BM_Compact_PopAll)->RangeMultiplier(10)->Range(1000, 10000000);
 
-static void BM_Pool_PushPop(benchmark::State& state) {
+static void BM_Compact_PushPop(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n * 2);
     for (auto _ : state) {
-        PoolHeap heap;
+        CompactHeap heap;
         for (int i = 0; i < n; i++)
             heap.push(data[i]);
         for (int i = n; i < n * 2; i++) {
@@ -122,9 +507,9 @@ static void BM_Pool_PushPop(benchmark::State& state) {
         benchmark::DoNotOptimize(heap.size());
     }
 }
-BENCHMARK(BM_Pool_PushPop)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK(BM_Compact_PushPop)->RangeMultiplier(10)->Range(1000, 1000000);
 
-static void BM_Pool_DecreaseKey(benchmark::State& state) {
+static void BM_Compact_DecreaseKey(benchmark::State& state) {
     const int n = static_cast<int>(state.range(0));
     auto data = make_random_ints(n);
     std::mt19937 rng(123);
@@ -133,8 +518,8 @@ static void BM_Pool_DecreaseKey(benchmark::State& state) {
         decrements[i] = rng() % 1000 + 1;
 
     for (auto _ : state) {
-        PoolHeap heap;
-        std::vector<PoolHeap::const_iterator> its;
+        CompactHeap heap;
+        std::vector<CompactHeap::const_iterator> its;
         its.reserve(n);
         for (int i = 0; i < n; i++)
             its.push_back(heap.push(data[i]));
@@ -143,7 +528,445 @@ static void BM_Pool_DecreaseKey(benchmark::State& state) {
         benchmark::DoNotOptimize(heap.top());
     }
 }
-BENCHMARK(BM_Pool_DecreaseKey)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK(BM_Compact_DecreaseKey)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// ---------- in-place construction benchmarks ----------
+
+// 64-byte event record whose constructors do real work: building one fills
+// the payload, copying or moving it copies all 64 bytes
+struct EventRecord {
+    unsigned long long time;
+    unsigned type, source;
+    unsigned char payload[48];
+
+    EventRecord(unsigned long long t, unsigned ty, unsigned src) : time(t), type(ty), source(src) {
+        for (unsigned i = 0; i < sizeof(payload); i++)
+            payload[i] = static_cast<unsigned char>(src + i);
+    }
+    EventRecord(const EventRecord& o) : time(o.time), type(o.type), source(o.source) {
+        std::copy(o.payload, o.payload + sizeof(payload), payload);
+    }
+    EventRecord& operator=(const EventRecord& o) {
+        time = o.time;
+        type = o.type;
+        source = o.source;
+        std::copy(o.payload, o.payload + sizeof(payload), payload);
+        return *this;
+    }
+    bool operator<(const EventRecord& o) const { return time < o.time; }
+};
+static_assert(sizeof(EventRecord) == 64, "EventRecord should be 64 bytes");
+
+template <class Pass>
+using EventHeap = PassHeap<Pass, EventRecord, std::less<EventRecord>, pool_allocator<EventRecord>>;
+
+template <class Pass>
+static void BM_Event_PushTemporary(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    for (auto _ : state) {
+        EventHeap<Pass> heap;
+        for (int i = 0; i < n; i++)
+            heap.push(EventRecord(data[i], i & 7, i));
+        benchmark::DoNotOptimize(heap.top());
+    }
+}
+BENCHMARK_PASSES(BM_Event_PushTemporary, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_Event_Emplace(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    for (auto _ : state) {
+        EventHeap<Pass> heap;
+        for (int i = 0; i < n; i++)
+            heap.emplace(data[i], i & 7, i);
+        benchmark::DoNotOptimize(heap.top());
+    }
+}
+BENCHMARK_PASSES(BM_Event_Emplace, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// the argument tuples are built outside the timed loop, as a batch of
+// incoming events would be
+template <class Pass>
+static void BM_Event_EmplaceRange(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    std::vector<std::tuple<unsigned long long, unsigned, unsigned>> args;
+    args.reserve(n);
+    for (int i = 0; i < n; i++)
+        args.emplace_back(data[i], i & 7, i);
+    for (auto _ : state) {
+        EventHeap<Pass> heap;
+        heap.emplace_range(args.begin(), args.end());
+        benchmark::DoNotOptimize(heap.top());
+    }
+}
+BENCHMARK_PASSES(BM_Event_EmplaceRange, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// ---------- snapshot restore vs re-pushing ----------
+
+template <class Pass>
+using SnapshotHeap = PassHeap<Pass, int, std::less<int>, pool_allocator<int>>;
+
+// a heap in its working shape: n pushes and n / 10 pops
+template <class Heap>
+static void make_snapshot_heap(Heap& heap, const std::vector<int>& data) {
+    for (int v : data)
+        heap.push(v);
+    for (std::size_t i = 0; i < data.size() / 10; i++)
+        heap.pop();
+}
+
+// read-only stream over a snapshot already in memory
+struct SnapshotBuf : std::streambuf {
+    explicit SnapshotBuf(const std::string& bytes) {
+        char* p = const_cast<char*>(bytes.data());
+        setg(p, p, p + bytes.size());
+    }
+};
+
+template <class Pass>
+static void BM_Snapshot_Save(benchmark::State& state) {
+    SnapshotHeap<Pass> heap;
+    make_snapshot_heap(heap, make_random_ints(static_cast<int>(state.range(0))));
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        std::ostringstream out;
+        heap.save(out);
+        bytes = out.str().size();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK_PASSES(BM_Snapshot_Save, ->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond));
+
+template <class Pass>
+static void BM_Snapshot_Load(benchmark::State& state) {
+    std::string bytes;
+    {
+        SnapshotHeap<Pass> heap;
+        make_snapshot_heap(heap, make_random_ints(static_cast<int>(state.range(0))));
+        std::ostringstream out;
+        heap.save(out);
+        bytes = out.str();
+    }
+    for (auto _ : state) {
+        SnapshotBuf buf(bytes);
+        std::istream in(&buf);
+        SnapshotHeap<Pass> heap;
+        heap.load(in);
+        benchmark::DoNotOptimize(heap.top());
+    }
+}
+BENCHMARK_PASSES(BM_Snapshot_Load, ->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond));
+
+// the rebuild a snapshot replaces: push every surviving element again. The
+// result is one long root list, so the first pop still has to consolidate it
+template <class Pass>
+static void BM_Snapshot_RePush(benchmark::State& state) {
+    std::vector<int> survivors;
+    {
+        SnapshotHeap<Pass> heap;
+        make_snapshot_heap(heap, make_random_ints(static_cast<int>(state.range(0))));
+        survivors.reserve(heap.size());
+        while (!heap.empty()) {
+            survivors.push_back(heap.top());
+            heap.pop();
+        }
+        std::shuffle(survivors.begin(), survivors.end(), std::mt19937(7));
+    }
+    const bool consolidate = state.range(1) != 0;
+    for (auto _ : state) {
+        SnapshotHeap<Pass> heap;
+        heap.reserve(survivors.size());
+        for (int v : survivors)
+            heap.push(v);
+        if (consolidate)
+            heap.pop();
+        benchmark::DoNotOptimize(heap.top());
+    }
+}
+// second argument 1: include the first pop, after which the heap is linked
+// into half trees like the one a snapshot restores
+BENCHMARK_PASSES(BM_Snapshot_RePush, ->ArgsProduct({{1000, 10000, 100000, 1000000, 10000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond));
+
+// ---------- clear() ----------
+
+// builds a heap of n elements in its working shape (one pop links the root
+// list into half trees) and times clear() alone; the allocation count covers
+// clear() too
+template <class Heap, class Make>
+static void ClearWorkload(benchmark::State& state, Make make) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n + 1);
+    std::size_t allocs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            Heap heap;
+            heap.reserve(n + 1);
+            for (int v : data)
+                heap.push(make(v));
+            heap.pop();
+            std::size_t allocs_before = g_global_allocs;
+            state.ResumeTiming();
+            heap.clear();
+            state.PauseTiming();
+            allocs = g_global_allocs - allocs_before;
+        }
+        state.ResumeTiming();
+    }
+    state.counters["allocs"] = static_cast<double>(allocs);
+}
+
+static int make_int(int v) { return v; }
+static std::string make_string(int v) { return std::to_string(v); }
+
+template <class Pass>
+static void BM_Clear(benchmark::State& state) {
+    ClearWorkload<PassHeap<Pass>>(state, make_int);
+}
+BENCHMARK_PASSES(BM_Clear, ->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond));
+
+template <class Pass>
+static void BM_Clear_Pool(benchmark::State& state) {
+    ClearWorkload<PassHeap<Pass, int, std::less<int>, pool_allocator<int>>>(state, make_int);
+}
+BENCHMARK_PASSES(BM_Clear_Pool, ->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond));
+
+template <class Pass>
+static void BM_Clear_PoolString(benchmark::State& state) {
+    ClearWorkload<PassHeap<Pass, std::string, std::less<std::string>, pool_allocator<std::string>>>(state, make_string);
+}
+BENCHMARK_PASSES(BM_Clear_PoolString, ->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond));
+
+// ---------- keyed_rp_heap (cached keys) benchmarks ----------
+
+// A* style payload: the heap holds pointers to records much larger than a
+// cache line, laid out in random order, and orders them by one field
+struct ColdRecord {
+    double f;
+    char rest[120];
+};
+
+struct DerefLess {
+    bool operator()(const ColdRecord* a, const ColdRecord* b) const { return a->f < b->f; }
+};
+
+struct RecordKey {
+    double operator()(const ColdRecord* r) const { return r->f; }
+};
+
+static std::vector<ColdRecord*> make_cold_records(std::vector<ColdRecord>& storage, int n) {
+    std::mt19937 rng(42);
+    storage.resize(n);
+    std::vector<ColdRecord*> ptrs(n);
+    for (int i = 0; i < n; i++) {
+        storage[i].f = rng();
+        ptrs[i] = &storage[i];
+    }
+    std::shuffle(ptrs.begin(), ptrs.end(), rng);
+    return ptrs;
+}
+
+// push every record, lower the key of every other one, pop all; the
+// comparator either reads f through the pointer or the key cached in the node
+template <class Heap, class Decrease>
+static void PointerPayloadWorkload(benchmark::State& state, Decrease decrease) {
+    const int n = static_cast<int>(state.range(0));
+    std::vector<ColdRecord> storage;
+    auto ptrs = make_cold_records(storage, n);
+    std::vector<double> original(n);
+    for (int i = 0; i < n; i++)
+        original[i] = ptrs[i]->f;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < n; i++)
+            ptrs[i]->f = original[i];
+        state.ResumeTiming();
+        Heap heap;
+        std::vector<typename Heap::const_iterator> its;
+        its.reserve(n);
+        for (int i = 0; i < n; i++)
+            its.push_back(heap.push(ptrs[i]));
+        for (int i = 0; i < n; i += 2)
+            decrease(heap, its[i], ptrs[i]);
+        while (!heap.empty())
+            heap.pop();
+    }
+}
+
+template <class Pass>
+static void BM_Deref_PointerPayload(benchmark::State& state) {
+    using Heap = PassHeap<Pass, ColdRecord*, DerefLess>;
+    PointerPayloadWorkload<Heap>(state, [](Heap& heap, typename Heap::const_iterator it, ColdRecord* r) {
+        r->f -= 1000;
+        heap.decrease(it, r);
+    });
+}
+BENCHMARK_PASSES(BM_Deref_PointerPayload, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_Keyed_PointerPayload(benchmark::State& state) {
+    using Heap = keyed_rp_heap<ColdRecord*, RecordKey, std::less<double>, std::allocator<ColdRecord*>,
+                               rp_heap_no_stats, Pass>;
+    PointerPayloadWorkload<Heap>(state, [](Heap& heap, typename Heap::const_iterator it, ColdRecord* r) {
+        r->f -= 1000;
+        heap.decrease(it, r->f);
+    });
+}
+BENCHMARK_PASSES(BM_Keyed_PointerPayload, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// ---------- intrusive_rp_heap benchmarks ----------
+
+// scheduler style: the tasks live in the caller's array; each round queues
+// every task, moves a quarter of the deadlines earlier and drains the queue
+struct SchedTask {
+    int deadline;
+    rp_heap_hook<SchedTask> hook;
+    bool operator<(const SchedTask& o) const { return deadline < o.deadline; }
+};
+
+struct SchedLess {
+    bool operator()(const SchedTask* a, const SchedTask* b) const { return a->deadline < b->deadline; }
+};
+
+template <class Run>
+static void SchedulerWorkload(benchmark::State& state, Run run) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    std::vector<SchedTask> tasks(n);
+    for (auto _ : state) {
+        for (int i = 0; i < n; i++)
+            tasks[i].deadline = data[i];
+        run(tasks);
+    }
+}
+
+template <class Pass>
+static void BM_Sched_RpHeapOfPointers(benchmark::State& state) {
+    SchedulerWorkload(state, [](std::vector<SchedTask>& tasks) {
+        using Heap = PassHeap<Pass, SchedTask*, SchedLess, pool_allocator<SchedTask*>>;
+        Heap heap;
+        std::vector<typename Heap::const_iterator> its(tasks.size());
+        for (std::size_t i = 0; i < tasks.size(); i++)
+            its[i] = heap.push(&tasks[i]);
+        for (std::size_t i = 0; i < tasks.size(); i += 4) {
+            tasks[i].deadline -= 1000;
+            heap.decrease(its[i], &tasks[i]);
+        }
+        while (!heap.empty())
+            heap.pop();
+    });
+}
+BENCHMARK_PASSES(BM_Sched_RpHeapOfPointers, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+static void BM_Sched_Intrusive(benchmark::State& state) {
+    SchedulerWorkload(state, [](std::vector<SchedTask>& tasks) {
+        intrusive_rp_heap<SchedTask, &SchedTask::hook> heap;
+        for (SchedTask& t : tasks)
+            heap.push(t);
+        for (std::size_t i = 0; i < tasks.size(); i += 4) {
+            tasks[i].deadline -= 1000;
+            heap.decrease(tasks[i]);
+        }
+        while (!heap.empty())
+            heap.pop();
+    });
+}
+BENCHMARK(BM_Sched_Intrusive)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// ---------- steady-state allocation counting ----------
+
+// Reports the calls into the global operator new per iteration. A heap
+// whose allocator reserves its nodes (pool_allocator) promises none after
+// reserve(), so for those the benchmark fails if it sees any.
+static void ReportAllocs(benchmark::State& state, std::size_t allocs, bool expect_none) {
+    state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+    if (expect_none && allocs != 0)
+        state.SkipWithError("global allocations after reserve()");
+}
+
+// Same workload as BM_PushPop, but the heap is built once and reserved up
+// front; the timed loop is pure push+pop.
+template <class Heap>
+static void PushPopAllocs(benchmark::State& state, bool expect_none) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n * 2);
+    Heap heap;
+    heap.reserve(n + 1);
+    for (int i = 0; i < n; i++)
+        heap.push(data[i]);
+    std::size_t allocs = 0;
+    for (auto _ : state) {
+        std::size_t before = g_global_allocs;
+        for (int i = n; i < n * 2; i++) {
+            heap.push(data[i]);
+            heap.pop();
+        }
+        allocs += g_global_allocs - before;
+        benchmark::DoNotOptimize(heap.size());
+    }
+    ReportAllocs(state, allocs, expect_none);
+}
+
+template <class Pass>
+static void BM_PushPop_Allocs(benchmark::State& state) {
+    PushPopAllocs<PassHeap<Pass>>(state, false);
+}
+BENCHMARK_PASSES(BM_PushPop_Allocs, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+template <class Pass>
+static void BM_Pool_PushPop_Allocs(benchmark::State& state) {
+    PushPopAllocs<PoolHeap<Pass>>(state, true);
+}
+BENCHMARK_PASSES(BM_Pool_PushPop_Allocs, ->RangeMultiplier(10)->Range(1000, 1000000));
+
+// A rank-building churn at a steady size: every step erases a random element
+// and pushes it back larger, lowers another one, and every 64th step pops a
+// fresh minimum. Erasing and lowering cut half trees without shrinking the
+// ranks above them much, so ranks climb past log2(size) toward the
+// log_phi(size) bound that reserve() sizes the bucket workspace for.
+template <class Heap>
+static void ChurnAllocs(benchmark::State& state, bool expect_none) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n * 4);
+    Heap heap;
+    heap.reserve(n + 1);
+    std::vector<typename Heap::const_iterator> handles;
+    handles.reserve(n);
+    for (int i = 0; i < n; i++)
+        handles.push_back(heap.push(data[i] >> 2));
+    std::mt19937 rng(5);
+    std::size_t allocs = 0;
+    for (auto _ : state) {
+        std::size_t before = g_global_allocs;
+        for (int i = 0; i < n; i++) {
+            std::size_t j = rng() % n;
+            int v = *handles[j];
+            heap.erase(handles[j]);
+            handles[j] = heap.push(v + static_cast<int>(rng() % 1000));
+            std::size_t d = rng() % n;
+            heap.decrease(handles[d], *handles[d] - static_cast<int>(rng() % 1000));
+            if (i % 64 == 0) {
+                heap.push(INT_MIN);
+                heap.pop();
+            }
+        }
+        allocs += g_global_allocs - before;
+        benchmark::DoNotOptimize(heap.size());
+    }
+    ReportAllocs(state, allocs, expect_none);
+}
+
+template <class Pass>
+static void BM_Pool_Churn_Allocs(benchmark::State& state) {
+    ChurnAllocs<PoolHeap<Pass>>(state, true);
+}
+BENCHMARK_PASSES(BM_Pool_Churn_Allocs, ->RangeMultiplier(10)->Range(1000, 1000000)->Iterations(4));
 
 // ---------- std::priority_queue baselines ----------
 
@@ -171,3 +994,44 @@ static void BM_StdPQ_PopAll(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_StdPQ_PopAll)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// ---------- block source: 4 KiB vs 64 KiB blocks vs mmap huge-page arena ----------
+
+template <class Pass, class Alloc>
+static void BlockSourcePushPopAll(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    auto data = make_random_ints(n);
+    using Heap = PassHeap<Pass, int, std::less<int>, Alloc>;
+    std::unique_ptr<Heap> heap;
+    for (auto _ : state) {
+        state.PauseTiming();
+        heap.reset(new Heap());
+        state.ResumeTiming();
+        for (int i = 0; i < n; i++)
+            heap->push(data[i]);
+        while (!heap->empty())
+            heap->pop();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <class Pass>
+static void BM_Block4K_PushPopAll(benchmark::State& state) {
+    BlockSourcePushPopAll<Pass, pool_allocator<int, 4096>>(state);
+}
+template <class Pass>
+static void BM_Block64K_PushPopAll(benchmark::State& state) {
+    BlockSourcePushPopAll<Pass, pool_allocator<int, 65536>>(state);
+}
+template <class Pass>
+static void BM_Arena_PushPopAll(benchmark::State& state) {
+    BlockSourcePushPopAll<Pass, arena_pool_allocator<int>>(state);
+}
+template <class Pass>
+static void BM_ArenaNoTHP_PushPopAll(benchmark::State& state) {
+    BlockSourcePushPopAll<Pass, arena_pool_allocator<int, 4096, false>>(state);
+}
+BENCHMARK_PASSES(BM_Block4K_PushPopAll, ->RangeMultiplier(10)->Range(1000000, 100000000)->Unit(benchmark::kMillisecond));
+BENCHMARK_PASSES(BM_Block64K_PushPopAll, ->RangeMultiplier(10)->Range(1000000, 100000000)->Unit(benchmark::kMillisecond));
+BENCHMARK_PASSES(BM_Arena_PushPopAll, ->RangeMultiplier(10)->Range(1000000, 100000000)->Unit(benchmark::kMillisecond));
+BENCHMARK_PASSES(BM_ArenaNoTHP_PushPopAll, ->RangeMultiplier(10)->Range(1000000, 100000000)->Unit(benchmark::kMillisecond));
@@ -0,0 +1,72 @@
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "csr_graph.h"
+#include "sssp.h"
+
+static int max_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+// Graphs are generated once per process: a random graph with 1M vertices
+// and ~8M edges (weights 1..1000), and a 1000 x 1000 grid (weights 1..100).
+static const csr_graph& random_graph() {
+    static const csr_graph g = make_random_graph(1000000, 8, 1000, 1);
+    return g;
+}
+
+static const csr_graph& grid_graph() {
+    static const csr_graph g = make_grid_graph(1000, 1000, 100, 1);
+    return g;
+}
+
+static void report_edges(benchmark::State& state, const csr_graph& g) {
+    state.counters["edges_per_second"] = benchmark::Counter(
+        static_cast<double>(g.num_edges()) * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+// ---------- sequential Dijkstra baseline ----------
+
+static void BM_Dijkstra_Random(benchmark::State& state) {
+    const csr_graph& g = random_graph();
+    sssp_stats stats;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(dijkstra(g, 0, &stats));
+    report_edges(state, g);
+    state.counters["decreases"] = static_cast<double>(stats.decreases);
+}
+BENCHMARK(BM_Dijkstra_Random)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_Dijkstra_Grid(benchmark::State& state) {
+    const csr_graph& g = grid_graph();
+    sssp_stats stats;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(dijkstra(g, 0, &stats));
+    report_edges(state, g);
+    state.counters["decreases"] = static_cast<double>(stats.decreases);
+}
+BENCHMARK(BM_Dijkstra_Grid)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// ---------- parallel delta-stepping, Arg = thread count ----------
+
+static void BM_DeltaStepping_Random(benchmark::State& state) {
+    const csr_graph& g = random_graph();
+    const unsigned threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(delta_stepping(g, 0, 125, threads));
+    report_edges(state, g);
+}
+BENCHMARK(BM_DeltaStepping_Random)->RangeMultiplier(2)->Range(1, max_threads())
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_DeltaStepping_Grid(benchmark::State& state) {
+    const csr_graph& g = grid_graph();
+    const unsigned threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(delta_stepping(g, 0, 50, threads));
+    report_edges(state, g);
+}
+BENCHMARK(BM_DeltaStepping_Grid)->RangeMultiplier(2)->Range(1, max_threads())
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,336 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _COMPACT_RP_HEAP_H_
+#define _COMPACT_RP_HEAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rp_heap_core.h"
+
+// rank-pairing heap whose nodes live in one contiguous slab and are linked
+// by 32-bit indices instead of pointers; same algorithm (the shared core),
+// policies and interface as rp_heap, but an int node is 20 bytes instead of 40. As in rp_heap, pop()
+// destroys the element at once: a free slot holds no value, and a reused
+// slot constructs its element, so values need not be assignable to be pushed
+
+template <class _Ty>
+struct _Compact_node
+{
+    typedef std::uint32_t _Nodeidx;
+    // rank of a free slot, whose _Val is not alive
+    static const int _Free_rank = -1;
+
+    template <class _Valty,
+              class = typename std::enable_if<!std::is_same<typename std::decay<_Valty>::type, _Compact_node>::value>::type>
+    explicit _Compact_node(_Valty&& _V) : _Val(std::forward<_Valty>(_V)), _Rank(0)
+    {
+    }
+    // slab growth moves the live values along with the links
+    _Compact_node(_Compact_node&& _Right) noexcept(std::is_nothrow_move_constructible<_Ty>::value)
+        : _Left(_Right._Left), _Next(_Right._Next), _Parent(_Right._Parent), _Rank(_Right._Rank)
+    {
+        if (_Rank != _Free_rank)
+            ::new (static_cast<void*>(std::addressof(_Val))) _Ty(std::move(_Right._Val));
+    }
+    _Compact_node(const _Compact_node&) = delete;
+    _Compact_node& operator=(const _Compact_node&) = delete;
+    ~_Compact_node()
+    {
+        if (_Rank != _Free_rank)
+            _Val.~_Ty();
+    }
+
+    template <class _Valty>
+    void _Construct_value(_Valty&& _V)
+    {
+        ::new (static_cast<void*>(std::addressof(_Val))) _Ty(std::forward<_Valty>(_V));
+        _Rank = 0;
+    }
+    void _Destroy_value()
+    {
+        _Val.~_Ty();
+        _Rank = _Free_rank;
+    }
+
+    union
+    {
+        _Ty _Val;
+    };
+    _Nodeidx _Left, _Next, _Parent;
+    int _Rank;
+};
+
+template <class _Myheap>
+class _Compact_iterator
+{
+public:
+    friend _Myheap;
+    typedef typename _Myheap::_Nodeidx _Nodeidx;
+    typedef typename _Myheap::value_type value_type;
+    typedef typename _Myheap::difference_type difference_type;
+    typedef typename _Myheap::const_reference const_reference;
+    typedef typename _Myheap::const_pointer const_pointer;
+
+    _Compact_iterator(const _Myheap* _Heap = nullptr, _Nodeidx _Idx = _Myheap::_Nil)
+    {
+        this->_Heap = _Heap;
+        this->_Idx = _Idx;
+    }
+    const_reference operator*() const
+    {
+        return _Heap->_Myslab[_Idx]._Val;
+    }
+    const_pointer operator->() const
+    {
+        return &(operator*());
+    }
+    // stable position of the element in the slab, valid until it is popped
+    _Nodeidx index() const
+    {
+        return _Idx;
+    }
+    const _Myheap* _Heap;
+    _Nodeidx _Idx;
+};
+
+template <class _Ty, class _Pr = std::less<_Ty>, class _Alloc = std::allocator<_Ty>,
+          class _Stats = rp_heap_no_stats, class _Pass = rp_heap_multipass>
+class compact_rp_heap : private _Stats_base<_Stats>
+{
+public:
+    typedef compact_rp_heap<_Ty, _Pr, _Alloc, _Stats, _Pass> _Myt;
+    typedef _Compact_node<_Ty> _Node;
+    typedef typename _Node::_Nodeidx _Nodeidx;
+    static const _Nodeidx _Nil = static_cast<_Nodeidx>(-1);
+
+    typedef _Pr key_compare;
+
+    typedef _Alloc allocator_type;
+    typedef std::allocator_traits<_Alloc> _Alloc_traits;
+    typedef typename _Alloc_traits::template rebind_alloc<_Node> _Alty;
+    typedef typename _Alloc_traits::template rebind_alloc<_Nodeidx> _Alidx;
+    typedef typename _Alloc_traits::value_type value_type;
+    typedef typename _Alloc_traits::pointer pointer;
+    typedef typename _Alloc_traits::const_pointer const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename _Alloc_traits::difference_type difference_type;
+    typedef typename _Alloc_traits::size_type size_type;
+
+    typedef _Compact_iterator<_Myt> const_iterator;
+    friend const_iterator;
+    typedef _Stats stats_policy;
+    typedef _Pass consolidation_policy;
+
+    compact_rp_heap(const _Pr& _Pred = _Pr()) : comp(_Pred)
+    {
+        _Mysize = 0;
+        _Myhead = _Nil;
+        _Myfree = _Nil;
+    }
+
+    compact_rp_heap(const compact_rp_heap&) = delete;
+    compact_rp_heap& operator=(const compact_rp_heap&) = delete;
+
+    bool empty() const
+    {
+        return _Mysize == 0;
+    }
+
+    size_type size() const
+    {
+        return _Mysize;
+    }
+
+    const_reference top() const
+    {
+        return _Myslab[_Myhead]._Val;
+    }
+
+    const_iterator push(const value_type& _Val)
+    {
+        _Nodeidx _Idx = _Buynode(_Val);
+        _Algo::_Insert_root(_Nodes(), _Myhead, _Idx);
+        _Mysize++;
+        return const_iterator(this, _Idx);
+    }
+
+    const_iterator push(value_type&& x)
+    {
+        _Nodeidx _Idx = _Buynode(std::move(x));
+        _Algo::_Insert_root(_Nodes(), _Myhead, _Idx);
+        _Mysize++;
+        return const_iterator(this, _Idx);
+    }
+
+    void pop() //delete min
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Freenode(_Algo::_Unlink_head(_Nodes(), _Myhead, _Mybucket, _Mysize));
+    }
+
+    void pop(value_type& _Val)
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Val = std::move(_Myslab[_Myhead]._Val);
+        pop();
+    }
+
+    void reserve(size_type _Count)
+    {
+        if (_Count >= _Nil)
+            throw std::length_error("reserve error: more than 2^32 - 1 nodes");
+        _Myslab.reserve(_Count);
+        size_type _Bound = _Rp_bucket_size_for(_Count);
+        if (_Mybucket.size() < _Bound)
+            _Mybucket.resize(_Bound, _Nil);
+    }
+
+    // destroy every element; the slab keeps its capacity
+    void clear()
+    {
+        _Myslab.clear();
+        _Mysize = 0;
+        _Myhead = _Nil;
+        _Myfree = _Nil;
+    }
+
+    void decrease(const_iterator _It, const value_type& _Val)
+    {
+        _Nodeidx _Idx = _It._Idx;
+        _Node& _Cur = _Myslab[_Idx];
+        if (_Compare(_Val, _Cur._Val))
+            _Cur._Val = _Val;
+        if (_Idx == _Myhead)
+            return;
+        if (_Cur._Parent == _Nil) //one of the roots
+        {
+            if (_Algo::_Less(_Nodes(), _Idx, _Myhead))
+                _Myhead = _Idx;
+        }
+        else
+        {
+            _Algo::_Cut(_Nodes(), _Idx);
+            _Algo::_Insert_root(_Nodes(), _Myhead, _Idx);
+        }
+    }
+
+    // operation counters collected by the _Stats policy (all zero with the
+    // default rp_heap_no_stats)
+    rp_heap_stats stats() const
+    {
+        return this->_Get_stats().snapshot();
+    }
+
+    void reset_stats()
+    {
+        this->_Get_stats().reset();
+    }
+
+private:
+
+    template <class _Valty>
+    _Nodeidx _Buynode(_Valty&& _Val)
+    {
+        _Nodeidx _Idx;
+        if (_Myfree != _Nil)
+        {
+            // construct first: if that throws, the slot is still free
+            _Idx = _Myfree;
+            _Myslab[_Idx]._Construct_value(std::forward<_Valty>(_Val));
+            _Myfree = _Myslab[_Idx]._Next;
+        }
+        else
+        {
+            if (_Myslab.size() >= _Nil)
+                throw std::length_error("push error: more than 2^32 - 1 nodes");
+            _Idx = static_cast<_Nodeidx>(_Myslab.size());
+            _Myslab.emplace_back(std::forward<_Valty>(_Val));
+        }
+        _Node& _Cur = _Myslab[_Idx];
+        _Cur._Left = _Cur._Next = _Cur._Parent = _Nil;
+        return _Idx;
+    }
+
+    void _Freenode(_Nodeidx _Idx)
+    {
+        _Myslab[_Idx]._Destroy_value();
+        _Myslab[_Idx]._Next = _Myfree;
+        _Myfree = _Idx;
+        _Mysize--;
+    }
+
+    bool _Compare(const value_type& _Left, const value_type& _Right) const
+    {
+        this->_Get_stats().on_compare();
+        return comp(_Left, _Right);
+    }
+
+    // the node access the shared core runs on: links are slab indices
+    struct _Node_access
+    {
+        typedef typename compact_rp_heap::_Nodeidx _Nodeptr;
+        compact_rp_heap* _Heap;
+
+        _Nodeptr nil() const { return _Nil; }
+        _Nodeptr& left(_Nodeptr _Idx) const { return _Heap->_Myslab[_Idx]._Left; }
+        _Nodeptr& next(_Nodeptr _Idx) const { return _Heap->_Myslab[_Idx]._Next; }
+        _Nodeptr& parent(_Nodeptr _Idx) const { return _Heap->_Myslab[_Idx]._Parent; }
+        int& rank(_Nodeptr _Idx) const { return _Heap->_Myslab[_Idx]._Rank; }
+        bool less(_Nodeptr _Left, _Nodeptr _Right) const
+        {
+            return _Heap->comp(_Heap->_Myslab[_Left]._Val, _Heap->_Myslab[_Right]._Val);
+        }
+        _Stats& stats() const { return _Heap->_Get_stats(); }
+    };
+    typedef _Rp_algo<_Node_access, _Pass> _Algo;
+
+    _Node_access _Nodes()
+    {
+        return _Node_access{this};
+    }
+
+    _Pr comp;
+    _Nodeidx _Myhead;
+    _Nodeidx _Myfree; // freelist of slab slots, chained through _Next
+    size_type _Mysize;
+    std::vector<_Node, _Alty> _Myslab;
+    std::vector<_Nodeidx, _Alidx> _Mybucket;
+};
+
+template <class _Ty>
+const int _Compact_node<_Ty>::_Free_rank;
+
+template <class _Ty, class _Pr, class _Alloc, class _Stats, class _Pass>
+const typename compact_rp_heap<_Ty, _Pr, _Alloc, _Stats, _Pass>::_Nodeidx
+    compact_rp_heap<_Ty, _Pr, _Alloc, _Stats, _Pass>::_Nil;
+
+#endif /* _COMPACT_RP_HEAP_H_ */
@@ -0,0 +1,250 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _CONCURRENT_RP_HEAP_H_
+#define _CONCURRENT_RP_HEAP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "rp_heap.h"
+
+/// Relaxed concurrent priority queue (MultiQueue) over sharded rp_heaps.
+///
+/// Each shard is an rp_heap guarded by its own spinlock. push() inserts into
+/// a random shard; try_pop() locks two random shards and removes the smaller
+/// of their tops. The element returned is therefore not always the global
+/// minimum, but with c * threads shards its expected rank is O(shards).
+/// A single shard gives an exact (serialized) priority queue.
+///
+/// Shards do not share nodes, so there are no decrease-key handles.
+template <class _Ty, class _Pr = std::less<_Ty>, class _Alloc = std::allocator<_Ty>>
+class concurrent_rp_heap
+{
+public:
+    typedef rp_heap<_Ty, _Pr, _Alloc> heap_type;
+    typedef typename heap_type::value_type value_type;
+    typedef typename heap_type::size_type size_type;
+    typedef typename heap_type::const_reference const_reference;
+    typedef _Pr key_compare;
+
+    explicit concurrent_rp_heap(size_type _Shards = 2 * _Default_threads(), const _Pr& _Pred = _Pr())
+        : comp(_Pred), _Myshards(_Shards ? _Shards : 1)
+    {
+        // new[] only guarantees alignof(max_align_t) before C++17, so
+        // over-allocate and align the shard array by hand
+        _Mystorage.reset(new char[_Myshards * sizeof(_Shard) + alignof(_Shard) - 1]);
+        std::uintptr_t _Addr = reinterpret_cast<std::uintptr_t>(_Mystorage.get());
+        _Addr = (_Addr + alignof(_Shard) - 1) & ~static_cast<std::uintptr_t>(alignof(_Shard) - 1);
+        _Myshard = reinterpret_cast<_Shard*>(_Addr);
+        size_type i = 0;
+        try
+        {
+            for (; i < _Myshards; ++i)
+                ::new (static_cast<void*>(_Myshard + i)) _Shard(_Pred);
+        }
+        catch (...)
+        {
+            while (i > 0)
+                _Myshard[--i].~_Shard();
+            throw;
+        }
+    }
+
+    ~concurrent_rp_heap()
+    {
+        for (size_type i = 0; i < _Myshards; ++i)
+            _Myshard[i].~_Shard();
+    }
+
+    concurrent_rp_heap(const concurrent_rp_heap&) = delete;
+    concurrent_rp_heap& operator=(const concurrent_rp_heap&) = delete;
+
+    size_type shard_count() const
+    {
+        return _Myshards;
+    }
+
+    // number of elements; only a snapshot while other threads are active
+    size_type size() const
+    {
+        size_type _Count = 0;
+        for (size_type i = 0; i < _Myshards; ++i)
+            _Count += _Myshard[i]._Size.load(std::memory_order_relaxed);
+        return _Count;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    void push(const value_type& _Val)
+    {
+        _Shard& _Sh = _Lock_random();
+        std::lock_guard<_Spinlock> _Guard(_Sh._Lock, std::adopt_lock);
+        _Sh._Heap.push(_Val);
+        _Sh._Size.store(_Sh._Heap.size(), std::memory_order_relaxed);
+    }
+
+    void push(value_type&& x)
+    {
+        _Shard& _Sh = _Lock_random();
+        std::lock_guard<_Spinlock> _Guard(_Sh._Lock, std::adopt_lock);
+        _Sh._Heap.push(std::move(x));
+        _Sh._Size.store(_Sh._Heap.size(), std::memory_order_relaxed);
+    }
+
+    // remove the smaller top of two random shards; returns false only when
+    // every shard was seen empty
+    bool try_pop(value_type& _Val)
+    {
+        if (_Myshards == 1)
+            return _Pop_from(_Myshard[0], _Val);
+        for (int _Tries = 0; _Tries < 8; )
+        {
+            size_type i = _Random() % _Myshards;
+            size_type j = _Random() % (_Myshards - 1);
+            if (j >= i)
+                j++;
+            _Shard& _A = _Myshard[i];
+            _Shard& _B = _Myshard[j];
+            if (_A._Size.load(std::memory_order_relaxed) == 0 && _B._Size.load(std::memory_order_relaxed) == 0)
+            {
+                _Tries++;
+                continue;
+            }
+            std::unique_lock<_Spinlock> _Lock_a(_A._Lock, std::try_to_lock);
+            if (!_Lock_a)
+                continue;
+            std::unique_lock<_Spinlock> _Lock_b(_B._Lock, std::try_to_lock);
+            if (!_Lock_b)
+                continue;
+            // the guards release both shards if the comparator or the
+            // value's move assignment throws
+            _Shard* _Best = nullptr;
+            if (!_A._Heap.empty())
+                _Best = &_A;
+            if (!_B._Heap.empty() && (_Best == nullptr || comp(_B._Heap.top(), _Best->_Heap.top())))
+                _Best = &_B;
+            if (_Best)
+            {
+                _Best->_Heap.pop(_Val);
+                _Best->_Size.store(_Best->_Heap.size(), std::memory_order_relaxed);
+                return true;
+            }
+            _Tries++;
+        }
+        // mostly empty: sweep all shards before reporting failure
+        size_type _Start = _Random() % _Myshards;
+        for (size_type k = 0; k < _Myshards; ++k)
+            if (_Pop_from(_Myshard[(_Start + k) % _Myshards], _Val))
+                return true;
+        return false;
+    }
+
+private:
+    // meets Lockable, so it is only ever held through lock_guard and
+    // unique_lock and a throwing push or pop cannot leave a shard locked
+    class _Spinlock
+    {
+    public:
+        bool try_lock()
+        {
+            return !_Flag.load(std::memory_order_relaxed) && !_Flag.exchange(true, std::memory_order_acquire);
+        }
+        void lock()
+        {
+            while (!try_lock())
+                std::this_thread::yield();
+        }
+        void unlock()
+        {
+            _Flag.store(false, std::memory_order_release);
+        }
+    private:
+        std::atomic<bool> _Flag{false};
+    };
+
+    // aligned to a cache line, with the heap stored inline, so no two
+    // shards' locks or heap headers share a line
+    struct alignas(64) _Shard
+    {
+        explicit _Shard(const _Pr& _Pred) : _Heap(_Pred)
+        {
+        }
+        _Spinlock _Lock;
+        std::atomic<size_type> _Size{0};
+        heap_type _Heap;
+    };
+
+    static size_type _Default_threads()
+    {
+        unsigned _Count = std::thread::hardware_concurrency();
+        return _Count ? _Count : 1;
+    }
+
+    // per-thread xorshift64*, seeded from the thread id
+    static std::uint64_t _Random()
+    {
+        static thread_local std::uint64_t _State =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull | 1;
+        _State ^= _State >> 12;
+        _State ^= _State << 25;
+        _State ^= _State >> 27;
+        return (_State * 0x2545F4914F6CDD1Dull) >> 32;
+    }
+
+    _Shard& _Lock_random()
+    {
+        if (_Myshards == 1)
+        {
+            _Myshard[0]._Lock.lock();
+            return _Myshard[0];
+        }
+        for (;;)
+        {
+            _Shard& _Sh = _Myshard[_Random() % _Myshards];
+            if (_Sh._Lock.try_lock())
+                return _Sh;
+        }
+    }
+
+    bool _Pop_from(_Shard& _Sh, value_type& _Val)
+    {
+        std::lock_guard<_Spinlock> _Guard(_Sh._Lock);
+        if (_Sh._Heap.empty())
+            return false;
+        _Sh._Heap.pop(_Val);
+        _Sh._Size.store(_Sh._Heap.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    _Pr comp;
+    size_type _Myshards;
+    std::unique_ptr<char[]> _Mystorage; // raw bytes behind _Myshard
+    _Shard* _Myshard;
+};
+
+#endif /* _CONCURRENT_RP_HEAP_H_ */
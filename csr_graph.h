@@ -0,0 +1,246 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef CSR_GRAPH_H_
+#define CSR_GRAPH_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Directed graph with non-negative integer edge weights in compressed
+/// sparse row form: the out-edges of vertex v are
+/// targets[offsets[v] .. offsets[v + 1]) with the matching weights.
+struct csr_graph
+{
+    using vertex_type = std::uint32_t;
+    using weight_type = std::uint32_t;
+
+    struct edge
+    {
+        vertex_type from;
+        vertex_type to;
+        weight_type weight;
+    };
+
+    std::vector<std::size_t> offsets{0};
+    std::vector<vertex_type> targets;
+    std::vector<weight_type> weights;
+
+    vertex_type num_vertices() const
+    {
+        return static_cast<vertex_type>(offsets.size() - 1);
+    }
+
+    std::size_t num_edges() const
+    {
+        return targets.size();
+    }
+
+    /// Builds the CSR arrays from an edge list with a counting sort on the
+    /// source vertex; edges of one vertex keep their input order.
+    static csr_graph from_edges(vertex_type n, const std::vector<edge>& edges)
+    {
+        csr_graph g;
+        g.offsets.assign(static_cast<std::size_t>(n) + 1, 0);
+        for (const edge& e : edges)
+        {
+            if (e.from >= n || e.to >= n)
+                throw std::out_of_range("csr_graph: edge endpoint out of range");
+            g.offsets[e.from + 1]++;
+        }
+        for (vertex_type v = 0; v < n; ++v)
+            g.offsets[v + 1] += g.offsets[v];
+        g.targets.resize(edges.size());
+        g.weights.resize(edges.size());
+        std::vector<std::size_t> next(g.offsets.begin(), g.offsets.end() - 1);
+        for (const edge& e : edges)
+        {
+            std::size_t slot = next[e.from]++;
+            g.targets[slot] = e.to;
+            g.weights[slot] = e.weight;
+        }
+        return g;
+    }
+};
+
+/// Random directed graph with n vertices and about n * avg_degree edges,
+/// weights uniform in [1, max_weight].
+inline csr_graph make_random_graph(csr_graph::vertex_type n, unsigned avg_degree,
+                                   csr_graph::weight_type max_weight, unsigned seed = 1)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<csr_graph::vertex_type> vertex(0, n - 1);
+    std::uniform_int_distribution<csr_graph::weight_type> weight(1, max_weight);
+    std::vector<csr_graph::edge> edges;
+    edges.reserve(static_cast<std::size_t>(n) * avg_degree);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(n) * avg_degree; ++i)
+        edges.push_back({vertex(rng), vertex(rng), weight(rng)});
+    return csr_graph::from_edges(n, edges);
+}
+
+/// 4-connected width x height grid with edges in both directions, weights
+/// uniform in [1, max_weight]; vertex (x, y) is y * width + x.
+inline csr_graph make_grid_graph(csr_graph::vertex_type width, csr_graph::vertex_type height,
+                                 csr_graph::weight_type max_weight, unsigned seed = 1)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<csr_graph::weight_type> weight(1, max_weight);
+    std::vector<csr_graph::edge> edges;
+    edges.reserve(static_cast<std::size_t>(width) * height * 4);
+    for (csr_graph::vertex_type y = 0; y < height; ++y)
+    {
+        for (csr_graph::vertex_type x = 0; x < width; ++x)
+        {
+            csr_graph::vertex_type v = y * width + x;
+            if (x + 1 < width)
+            {
+                edges.push_back({v, v + 1, weight(rng)});
+                edges.push_back({v + 1, v, weight(rng)});
+            }
+            if (y + 1 < height)
+            {
+                edges.push_back({v, v + width, weight(rng)});
+                edges.push_back({v + width, v, weight(rng)});
+            }
+        }
+    }
+    return csr_graph::from_edges(width * height, edges);
+}
+
+/// Synthetic stand-in for a road network: width x height junctions on a
+/// jittered grid, each street to the right / below present with
+/// probability 0.8 (in both directions), plus a sparse mesh of highways
+/// joining every 16th junction to the one 16 steps further with a 3x
+/// faster weight. Weights are scaled Euclidean lengths, so like DIMACS road
+/// graphs the result has average degree below 4 and geometric distances.
+inline csr_graph make_road_graph(csr_graph::vertex_type width, csr_graph::vertex_type height,
+                                 unsigned seed = 1)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-0.35, 0.35);
+    std::bernoulli_distribution street(0.8);
+    std::vector<double> xs(static_cast<std::size_t>(width) * height), ys(xs.size());
+    for (csr_graph::vertex_type y = 0; y < height; ++y)
+        for (csr_graph::vertex_type x = 0; x < width; ++x)
+        {
+            xs[y * width + x] = x + jitter(rng);
+            ys[y * width + x] = y + jitter(rng);
+        }
+    std::vector<csr_graph::edge> edges;
+    auto connect = [&](csr_graph::vertex_type a, csr_graph::vertex_type b, double speed) {
+        double dx = xs[a] - xs[b], dy = ys[a] - ys[b];
+        csr_graph::weight_type w = static_cast<csr_graph::weight_type>(std::sqrt(dx * dx + dy * dy) * 1000 / speed) + 1;
+        edges.push_back({a, b, w});
+        edges.push_back({b, a, w});
+    };
+    for (csr_graph::vertex_type y = 0; y < height; ++y)
+    {
+        for (csr_graph::vertex_type x = 0; x < width; ++x)
+        {
+            csr_graph::vertex_type v = y * width + x;
+            if (x + 1 < width && street(rng))
+                connect(v, v + 1, 1);
+            if (y + 1 < height && street(rng))
+                connect(v, v + width, 1);
+            if (x % 16 == 0 && y % 16 == 0)
+            {
+                if (x + 16 < width)
+                    connect(v, v + 16, 3);
+                if (y + 16 < height)
+                    connect(v, v + 16 * width, 3);
+            }
+        }
+    }
+    return csr_graph::from_edges(width * height, edges);
+}
+
+/// Reads a graph in the DIMACS shortest-path format (.gr) used by the 9th
+/// DIMACS challenge road networks: 'c' comment lines, one
+/// 'p sp <vertices> <arcs>' line, then 'a <from> <to> <weight>' lines with
+/// 1-based vertex ids. Throws std::runtime_error on malformed input.
+inline csr_graph load_dimacs_gr(std::istream& in)
+{
+    std::vector<csr_graph::edge> edges;
+    csr_graph::vertex_type n = 0;
+    bool have_problem = false;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(in, line))
+    {
+        line_no++;
+        std::istringstream fields(line);
+        char kind = 'c';
+        // blank and whitespace-only lines read as comments too
+        if (!(fields >> kind) || kind == 'c')
+            continue;
+        if (kind == 'p')
+        {
+            std::string format;
+            unsigned long long vertices, arcs;
+            if (!(fields >> format >> vertices >> arcs) || format != "sp" || vertices > 0xFFFFFFFEull)
+                throw std::runtime_error("load_dimacs_gr: bad problem line " + std::to_string(line_no));
+            n = static_cast<csr_graph::vertex_type>(vertices);
+            edges.reserve(static_cast<std::size_t>(arcs));
+            have_problem = true;
+        }
+        else if (kind == 'a')
+        {
+            unsigned long long from, to, weight;
+            if (!have_problem || !(fields >> from >> to >> weight)
+                || from == 0 || to == 0 || from > n || to > n || weight > 0xFFFFFFFFull)
+                throw std::runtime_error("load_dimacs_gr: bad arc line " + std::to_string(line_no));
+            edges.push_back({static_cast<csr_graph::vertex_type>(from - 1),
+                             static_cast<csr_graph::vertex_type>(to - 1),
+                             static_cast<csr_graph::weight_type>(weight)});
+        }
+        else
+            throw std::runtime_error("load_dimacs_gr: unknown line " + std::to_string(line_no));
+    }
+    if (!have_problem)
+        throw std::runtime_error("load_dimacs_gr: missing problem line");
+    return csr_graph::from_edges(n, edges);
+}
+
+inline csr_graph load_dimacs_gr(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("load_dimacs_gr: cannot open " + path);
+    return load_dimacs_gr(in);
+}
+
+/// Writes g in the DIMACS .gr format read by load_dimacs_gr().
+inline void write_dimacs_gr(std::ostream& out, const csr_graph& g)
+{
+    out << "p sp " << g.num_vertices() << ' ' << g.num_edges() << '\n';
+    for (csr_graph::vertex_type v = 0; v < g.num_vertices(); ++v)
+        for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e)
+            out << "a " << v + 1 << ' ' << g.targets[e] + 1 << ' ' << g.weights[e] << '\n';
+}
+
+#endif /* CSR_GRAPH_H_ */
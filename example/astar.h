@@ -0,0 +1,558 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <deque> // hold the result path
+#include <fstream>
+#include <functional> // std::hash
+#include <istream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../indexed_rp_heap.h"
+#include "../intrusive_rp_heap.h"
+#include "AstarNode.h"
+
+// Grid maps are stored row by row: map[y][x] is 0 for a passable cell and 1
+// for an obstacle; L is the number of columns and W the number of rows.
+typedef std::vector<std::vector<unsigned char>> grid_map;
+
+const double SQRT2 = std::sqrt(2.0);
+
+// Custom hash function for Point2D.
+struct Point2DHash {
+    size_t operator()(const Point2D &point) const {
+        return 51 + std::hash<int>()(point.x) * 51 + std::hash<int>()(point.y);
+    }
+};
+
+inline double heuristic(int x1, int y1, int x2, int y2) {
+    return std::abs(x1 - x2) + std::abs(y1 - y2); // Manhattan distance
+    // Other distance metrics can be swapped in here as needed
+}
+
+inline bool compare(const AstarNode *left, const AstarNode *right) {
+    return *left < *right; // Assuming AstarNode has an overloaded < operator
+}
+
+// What one search did: the cost of the path found (-1 if none) and the
+// number of nodes taken off the open set.
+struct astar_stats {
+    double cost = -1;
+    std::size_t expansions = 0;
+};
+
+// 8-connected A* without corner cutting; returns the path from s to g, or an
+// empty path if g is unreachable. Cells are numbered y * L + x (a size_t),
+// so the open set is an indexed_rp_heap over the cell ids and the per-cell
+// state lives in flat arrays instead of hash maps.
+inline std::deque<Node> shortest_path_a_star(const grid_map &map, int L, int W, const Node &s, const Node &g,
+                                             astar_stats *stats = nullptr) {
+    const std::size_t cells = static_cast<std::size_t>(L) * W;
+    indexed_rp_heap<double> open_set(cells);
+    std::vector<char> closed(cells, 0);
+    std::vector<double> g_score(cells);
+    const std::size_t none = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> parent(cells, none);
+    std::deque<Node> result_path;
+    astar_stats local;
+
+    const std::size_t start = static_cast<std::size_t>(s.y) * L + s.x;
+    g_score[start] = 0;
+    open_set.push(start, heuristic(s.x, s.y, g.x, g.y));
+
+    const int DIRECTIONS = 8;
+    const int dx[DIRECTIONS] = {0, 1, 0, -1, -1, 1, 1, -1};
+    const int dy[DIRECTIONS] = {-1, 0, 1, 0, -1, -1, 1, 1};
+
+    while (!open_set.empty()) {
+        const std::size_t current = open_set.pop();
+        const int x = static_cast<int>(current % L), y = static_cast<int>(current / L);
+        local.expansions++;
+
+        if (x == g.x && y == g.y) {
+            local.cost = g_score[current];
+            for (std::size_t cell = current; cell != none; cell = parent[cell])
+                result_path.push_front(Node(static_cast<int>(cell % L), static_cast<int>(cell / L)));
+            open_set.clear();
+            break;
+        }
+
+        closed[current] = 1;
+
+        for (int i = 0; i < DIRECTIONS; ++i) {
+            int next_x = x + dx[i];
+            int next_y = y + dy[i];
+
+            if (next_y >= 0 && next_y < W && next_x >= 0 && next_x < L && map[next_y][next_x] == 0) {
+                /*
+                 *if the current move being checked is a diagonal one, and there is an obstacle in the path of the diagonal move,
+                 then continue
+                 */
+                if ((dx[i] & dy[i]) && (map[next_y][x] == 1 || map[y][next_x] == 1)) {
+                    continue;
+                }
+                const std::size_t neighbor = static_cast<std::size_t>(next_y) * L + next_x;
+                if (closed[neighbor]) {
+                    continue;
+                }
+
+                double tentative = g_score[current] + ((dx[i] & dy[i]) == 0 ? 1 : SQRT2);
+
+                if (open_set.contains(neighbor)) {
+                    if (tentative < g_score[neighbor]) {
+                        parent[neighbor] = current;
+                        g_score[neighbor] = tentative;
+                        open_set.decrease(neighbor, tentative + heuristic(next_x, next_y, g.x, g.y));
+                    }
+                } else {
+                    parent[neighbor] = current;
+                    g_score[neighbor] = tentative;
+                    open_set.push(neighbor, tentative + heuristic(next_x, next_y, g.x, g.y));
+                }
+            }
+        }
+    }
+    if (stats)
+        *stats = local;
+    return result_path;
+}
+
+// A grid_map flattened row-major into one byte per cell. Searches only read
+// it, so one FlatGrid can back any number of GridAStar engines, including
+// engines on different threads.
+class FlatGrid {
+public:
+    FlatGrid(const grid_map &map, int L, int W) : L_(L), W_(W), cells_(static_cast<std::size_t>(L) * W) {
+        for (int y = 0; y < W; ++y)
+            for (int x = 0; x < L; ++x)
+                cells_[static_cast<std::size_t>(y) * L + x] = map[y][x];
+    }
+
+    int width() const { return L_; }
+    int height() const { return W_; }
+    std::size_t cells() const { return cells_.size(); }
+
+    bool blocked(int x, int y) const {
+        return cells_[static_cast<std::size_t>(y) * L_ + x] != 0;
+    }
+
+private:
+    int L_, W_;
+    std::vector<unsigned char> cells_;
+};
+
+// Reusable A* over one map. The per-cell search state (g, f, parent and the
+// open-set links) is stamped with the query's generation: a cell whose stamp
+// is not the current generation is untouched, so a new query needs no
+// clearing, and a stamped cell that is not in the open set is closed. The
+// open set is an intrusive_rp_heap threaded through those states. After the
+// first queries have sized the state and the path vector, queries run
+// back-to-back with no allocation and return the same paths as
+// shortest_path_a_star. The map is shared read-only; only the search state
+// belongs to the engine.
+//
+// Map is any grid with width(), height(), cells() and blocked(x, y): a
+// FlatGrid here, or the bit-packed TiledGrid of tiled_map.h, which can be
+// mapped straight from a file. GridAStar is the engine over a FlatGrid.
+//
+// The state is committed lazily, one 32 x 32 block of cells (64 KiB) the
+// first time a search reaches it, and kept for later queries, so an engine
+// holds state only for the part of the map its searches have explored.
+// Building one costs a directory of one pointer per block, 1/128 byte per
+// cell, allocated with calloc so that on a large map its untouched pages
+// are never backed either. Cells are addressed by (x, y) and block, never
+// by a linear int id, so the map size is bounded only by the int
+// coordinates of Map::blocked().
+template <class Map>
+class BasicGridAStar {
+public:
+    typedef Map map_type;
+
+    explicit BasicGridAStar(std::shared_ptr<const Map> map)
+        : map_(std::move(map)), L_(map_->width()), W_(map_->height()),
+          blocks_x_((static_cast<std::size_t>(L_) + block_side - 1) / block_side),
+          directory_size_(blocks_x_ * ((static_cast<std::size_t>(W_) + block_side - 1) / block_side)),
+          directory_(new_directory(directory_size_)) {}
+
+    BasicGridAStar(const grid_map &map, int L, int W) : BasicGridAStar(std::make_shared<const Map>(map, L, W)) {}
+
+    int width() const { return L_; }
+    int height() const { return W_; }
+    const std::shared_ptr<const Map> &map() const { return map_; }
+
+    // bytes of search state committed so far, directory included
+    std::size_t state_bytes() const {
+        return blocks_.size() * block_cells * sizeof(cell_state) + directory_size_ * sizeof(cell_state *);
+    }
+
+    // Finds a path from (sx, sy) to (gx, gy) and writes it to path, start
+    // first; returns false (with path empty) if the goal is unreachable.
+    bool search(int sx, int sy, int gx, int gy, std::vector<Node> &path, astar_stats *stats = nullptr) {
+        next_generation();
+        path.clear();
+        astar_stats local;
+        // a map that throws from blocked(), or a block that cannot be
+        // committed, must not leave cells of this query in the open set of
+        // the next one
+        try {
+            run_search(sx, sy, gx, gy, path, local);
+        } catch (...) {
+            open_.clear();
+            throw;
+        }
+        open_.clear();
+        if (stats)
+            *stats = local;
+        return !path.empty();
+    }
+
+    // Same as shortest_path_a_star, for callers that want a deque.
+    std::deque<Node> find_path(const Node &s, const Node &g, astar_stats *stats = nullptr) {
+        std::vector<Node> path;
+        search(s.x, s.y, g.x, g.y, path, stats);
+        return std::deque<Node>(path.begin(), path.end());
+    }
+
+private:
+    static const int DIRECTIONS = 8;
+
+    struct cell_state {
+        rp_heap_hook<cell_state> hook; // open-set links
+        double f = 0;                  // g + heuristic, the open-set key
+        double g = 0;
+        unsigned stamp = 0;
+        int x = 0, y = 0;
+        signed char parent = -1; // direction taken into this cell, -1 at the start
+    };
+
+    struct f_less {
+        bool operator()(const cell_state &l, const cell_state &r) const { return l.f < r.f; }
+    };
+
+    struct free_deleter {
+        void operator()(cell_state **p) const { std::free(p); }
+    };
+
+    static const int block_shift = 5;
+    static const int block_side = 1 << block_shift;
+    static const std::size_t block_cells = std::size_t(block_side) * block_side;
+
+    static std::unique_ptr<cell_state *[], free_deleter> new_directory(std::size_t blocks) {
+        void *p = std::calloc(blocks ? blocks : 1, sizeof(cell_state *));
+        if (!p)
+            throw std::bad_alloc();
+        return std::unique_ptr<cell_state *[], free_deleter>(static_cast<cell_state **>(p));
+    }
+
+    // the search proper; search() empties the open set after it
+    void run_search(int sx, int sy, int gx, int gy, std::vector<Node> &path, astar_stats &local) {
+        touch(sx, sy).g = 0;
+        push(state(sx, sy), heuristic(sx, sy, gx, gy));
+
+        const int dx[DIRECTIONS] = {0, 1, 0, -1, -1, 1, 1, -1};
+        const int dy[DIRECTIONS] = {-1, 0, 1, 0, -1, -1, 1, 1};
+
+        while (!open_.empty()) {
+            cell_state &cur = open_.top();
+            open_.pop();
+            const int x = cur.x, y = cur.y;
+            local.expansions++;
+
+            if (x == gx && y == gy) {
+                local.cost = cur.g;
+                for (const cell_state *st = &cur;; ) {
+                    path.push_back(Node(st->x, st->y));
+                    if (st->parent < 0)
+                        break;
+                    st = &state(st->x - dx[st->parent], st->y - dy[st->parent]);
+                }
+                std::reverse(path.begin(), path.end());
+                break;
+            }
+
+            const double g_current = cur.g;
+
+            for (int i = 0; i < DIRECTIONS; ++i) {
+                const int next_x = x + dx[i];
+                const int next_y = y + dy[i];
+                if (next_y < 0 || next_y >= W_ || next_x < 0 || next_x >= L_ || blocked(next_x, next_y))
+                    continue;
+                // no corner cutting on diagonal moves
+                if ((dx[i] & dy[i]) && (blocked(x, next_y) || blocked(next_x, y)))
+                    continue;
+                const double tentative = g_current + ((dx[i] & dy[i]) == 0 ? 1 : SQRT2);
+                cell_state *st = find(next_x, next_y);
+                if (st && st->stamp == generation_) {
+                    // else: stamped this query and not open, i.e. closed
+                    if (st->hook.is_linked() && tentative < st->g) {
+                        st->parent = static_cast<signed char>(i);
+                        st->g = tentative;
+                        // as in indexed_rp_heap::decrease, a key that rounds
+                        // to the old one leaves the heap as it is
+                        const double f = tentative + heuristic(next_x, next_y, gx, gy);
+                        if (f < st->f) {
+                            st->f = f;
+                            open_.decrease(*st);
+                        }
+                    }
+                } else {
+                    cell_state &fresh = touch(next_x, next_y);
+                    fresh.parent = static_cast<signed char>(i);
+                    fresh.g = tentative;
+                    push(fresh, tentative + heuristic(next_x, next_y, gx, gy));
+                }
+            }
+        }
+    }
+
+    bool blocked(int x, int y) const {
+        return map_->blocked(x, y);
+    }
+
+    std::size_t block_of(int x, int y) const {
+        return static_cast<std::size_t>(y >> block_shift) * blocks_x_ + static_cast<std::size_t>(x >> block_shift);
+    }
+
+    static std::size_t offset_in_block(int x, int y) {
+        return (static_cast<std::size_t>(y & (block_side - 1)) << block_shift) | static_cast<std::size_t>(x & (block_side - 1));
+    }
+
+    // the state of (x, y), or null if its block was never committed
+    cell_state *find(int x, int y) const {
+        cell_state *block = directory_[block_of(x, y)];
+        return block ? block + offset_in_block(x, y) : nullptr;
+    }
+
+    // the state of a cell this query has stamped
+    cell_state &state(int x, int y) const {
+        return directory_[block_of(x, y)][offset_in_block(x, y)];
+    }
+
+    // first visit of a cell in this query: commit its block if needed,
+    // reset its state and stamp it
+    cell_state &touch(int x, int y) {
+        cell_state *&block = directory_[block_of(x, y)];
+        if (!block)
+            block = commit_block(x, y);
+        cell_state &st = block[offset_in_block(x, y)];
+        st.stamp = generation_;
+        st.parent = -1;
+        return st;
+    }
+
+    cell_state *commit_block(int x, int y) {
+        blocks_.reserve(blocks_.size() + 1);
+        std::unique_ptr<cell_state[]> block(new cell_state[block_cells]);
+        const int x0 = x & ~(block_side - 1), y0 = y & ~(block_side - 1);
+        for (std::size_t i = 0; i < block_cells; ++i) {
+            block[i].x = x0 + static_cast<int>(i & (block_side - 1));
+            block[i].y = y0 + static_cast<int>(i >> block_shift);
+        }
+        blocks_.push_back(std::move(block));
+        return blocks_.back().get();
+    }
+
+    void push(cell_state &st, double f) {
+        st.f = f;
+        open_.push(st);
+    }
+
+    void next_generation() {
+        if (++generation_ == 0) {
+            // the stamp wrapped: forget every old stamp once
+            for (const std::unique_ptr<cell_state[]> &block : blocks_)
+                for (std::size_t i = 0; i < block_cells; ++i)
+                    block[i].stamp = 0;
+            generation_ = 1;
+        }
+    }
+
+    std::shared_ptr<const Map> map_;
+    int L_, W_;
+    std::size_t blocks_x_, directory_size_;
+    std::unique_ptr<cell_state *[], free_deleter> directory_; // block of cells -> its state, or null
+    std::vector<std::unique_ptr<cell_state[]>> blocks_;        // the committed blocks
+    intrusive_rp_heap<cell_state, &cell_state::hook, f_less> open_;
+    unsigned generation_ = 0;
+};
+
+typedef BasicGridAStar<FlatGrid> GridAStar;
+
+// ---------- map and scenario files ----------
+
+// The example's binary format: one byte L, one byte W, then W rows of L bytes.
+inline bool load_bin_map(const std::string &path, grid_map &map, int &L, int &W) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+    unsigned char length = 0;
+    unsigned char width = 0;
+    file.read((char *) (&length), sizeof(length));
+    file.read((char *) (&width), sizeof(width));
+    if (!file)
+        return false;
+    map.assign(width, std::vector<unsigned char>(length));
+    for (int y = 0; y < width; ++y) {
+        file.read((char *) (map[y].data()), length);
+        if (!file)
+            return false;
+    }
+    L = length;
+    W = width;
+    return true;
+}
+
+// Moving AI benchmark maps (.map): a "type octile" header with height and
+// width, then rows where '.', 'G' and 'S' are passable and anything else
+// ('@', 'O', 'T', 'W') is an obstacle.
+inline bool load_movingai_map(std::istream &in, grid_map &map, int &L, int &W) {
+    std::string word;
+    int height = -1, width = -1;
+    while (in >> word && word != "map") {
+        if (word == "height")
+            in >> height;
+        else if (word == "width")
+            in >> width;
+        else if (word == "type")
+            in >> word;
+    }
+    if (word != "map" || height <= 0 || width <= 0)
+        return false;
+    map.assign(height, std::vector<unsigned char>(width, 1));
+    std::string row;
+    std::getline(in, row);
+    for (int y = 0; y < height; ++y) {
+        if (!std::getline(in, row))
+            return false;
+        for (int x = 0; x < width && x < (int) row.size(); ++x)
+            map[y][x] = (row[x] == '.' || row[x] == 'G' || row[x] == 'S') ? 0 : 1;
+    }
+    L = width;
+    W = height;
+    return true;
+}
+
+inline bool load_movingai_map(const std::string &path, grid_map &map, int &L, int &W) {
+    std::ifstream in(path);
+    return in && load_movingai_map(in, map, L, W);
+}
+
+// One query of a Moving AI scenario file (.scen); optimal is the reference
+// path length from the file, or -1 when unknown.
+struct scenario {
+    int start_x, start_y, goal_x, goal_y;
+    double optimal;
+};
+
+// Reads the "version 1" scenario format: bucket, map name, map width and
+// height, start x y, goal x y and optimal length per line.
+inline bool load_scenarios(std::istream &in, std::vector<scenario> &out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line.compare(0, 7, "version") == 0)
+            continue;
+        std::istringstream fields(line);
+        std::string bucket, map_name;
+        int map_w, map_h;
+        scenario sc;
+        if (!(fields >> bucket >> map_name >> map_w >> map_h >> sc.start_x >> sc.start_y >> sc.goal_x >> sc.goal_y))
+            return false;
+        if (!(fields >> sc.optimal))
+            sc.optimal = -1;
+        out.push_back(sc);
+    }
+    return true;
+}
+
+inline bool load_scenarios(const std::string &path, std::vector<scenario> &out) {
+    std::ifstream in(path);
+    return in && load_scenarios(in, out);
+}
+
+inline void write_scenarios(std::ostream &out, const std::string &map_name, int L, int W,
+                            const std::vector<scenario> &scenarios) {
+    out << "version 1\n";
+    for (const scenario &sc : scenarios) {
+        out << 0 << '\t' << map_name << '\t' << L << '\t' << W << '\t'
+            << sc.start_x << '\t' << sc.start_y << '\t' << sc.goal_x << '\t' << sc.goal_y << '\t'
+            << sc.optimal << '\n';
+    }
+}
+
+// Random map with the given fraction of obstacle cells.
+inline grid_map make_random_map(int L, int W, double density, unsigned seed = 1) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution blocked(density);
+    grid_map map(W, std::vector<unsigned char>(L));
+    for (int y = 0; y < W; ++y)
+        for (int x = 0; x < L; ++x)
+            map[y][x] = blocked(rng) ? 1 : 0;
+    return map;
+}
+
+// Picks count random start/goal pairs of passable cells in the same
+// 4-connected component (so every query has a path). The optimal length is
+// left unknown (-1).
+inline std::vector<scenario> generate_scenarios(const grid_map &map, int L, int W, std::size_t count,
+                                                unsigned seed = 1) {
+    // label components with a flood fill
+    std::vector<int> component(static_cast<std::size_t>(L) * W, -1);
+    std::vector<int> stack;
+    std::vector<std::vector<int>> members;
+    for (int start = 0; start < L * W; ++start) {
+        if (component[start] != -1 || map[start / L][start % L] != 0)
+            continue;
+        int label = (int) members.size();
+        members.emplace_back();
+        component[start] = label;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            members[label].push_back(cell);
+            int x = cell % L, y = cell / L;
+            const int nx[4] = {x + 1, x - 1, x, x};
+            const int ny[4] = {y, y, y + 1, y - 1};
+            for (int k = 0; k < 4; ++k) {
+                if (nx[k] < 0 || nx[k] >= L || ny[k] < 0 || ny[k] >= W || map[ny[k]][nx[k]] != 0)
+                    continue;
+                int next = ny[k] * L + nx[k];
+                if (component[next] == -1) {
+                    component[next] = label;
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+    std::vector<scenario> out;
+    std::vector<int> cells;
+    for (const std::vector<int> &m : members)
+        if (m.size() >= 2)
+            cells.insert(cells.end(), m.begin(), m.end());
+    if (cells.empty())
+        return out;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, cells.size() - 1);
+    while (out.size() < count) {
+        int a = cells[pick(rng)];
+        const std::vector<int> &m = members[component[a]];
+        int b = m[std::uniform_int_distribution<std::size_t>(0, m.size() - 1)(rng)];
+        if (a == b)
+            continue;
+        out.push_back({a % L, a / L, b % L, b / L, -1});
+    }
+    return out;
+}
+
+#endif /* ASTAR_H */
@@ -0,0 +1,169 @@
+#ifndef ASTAR_BATCH_H
+#define ASTAR_BATCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "astar.h"
+
+// One query of a batch: start and goal cell.
+typedef std::pair<Node, Node> path_query;
+
+// The answer to one query: the path from start to goal (empty if the goal is
+// unreachable) and what the search did.
+struct path_result {
+    std::vector<Node> path;
+    astar_stats stats;
+};
+
+// Runs batches of path queries against one map on a fixed pool of workers.
+// Every worker owns a BasicGridAStar<Map>, so its open set and per-cell state
+// are never shared; the map behind them is shared read-only. The pool is created
+// once and sleeps between batches. run() hands queries out one at a time from
+// an atomic counter, so a few long queries do not leave the other workers
+// idle, and writes each answer to the slot of its query, so the results come
+// back in input order whatever thread answered them. The calling thread works
+// as one of the workers, so threads == 1 starts no thread at all.
+//
+// Reusing the same results vector across batches keeps its path buffers, and
+// with them the steady-state batch allocation-free, as with GridAStar itself.
+// BatchAStar is the pool over a FlatGrid.
+template <class Map>
+class BasicBatchAStar {
+public:
+    typedef BasicGridAStar<Map> engine_type;
+
+    BasicBatchAStar(std::shared_ptr<const Map> map, unsigned threads) {
+        if (threads == 0)
+            threads = 1;
+        for (unsigned t = 0; t < threads; ++t)
+            engines_.push_back(std::unique_ptr<engine_type>(new engine_type(map)));
+        try {
+            for (unsigned t = 1; t < threads; ++t)
+                pool_.emplace_back(&BasicBatchAStar::worker_loop, this, t);
+        } catch (...) {
+            stop_pool();
+            throw;
+        }
+    }
+
+    BasicBatchAStar(const grid_map &map, int L, int W, unsigned threads)
+        : BasicBatchAStar(std::make_shared<const Map>(map, L, W), threads) {}
+
+    BasicBatchAStar(const BasicBatchAStar &) = delete;
+    BasicBatchAStar &operator=(const BasicBatchAStar &) = delete;
+
+    ~BasicBatchAStar() { stop_pool(); }
+
+    unsigned threads() const { return static_cast<unsigned>(engines_.size()); }
+
+    // Answers every query; results[i] belongs to queries[i]. Not reentrant:
+    // one batch at a time per pool. If a search throws, the workers stop
+    // taking queries, and once all of them are idle the first exception is
+    // rethrown here; the results of that batch are then unspecified.
+    void run(const std::vector<path_query> &queries, std::vector<path_result> &results) {
+        results.resize(queries.size());
+        if (queries.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queries_ = &queries;
+            results_ = &results;
+            next_.store(0, std::memory_order_relaxed);
+            busy_ = static_cast<unsigned>(pool_.size());
+            batch_++;
+        }
+        start_.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&] { return busy_ == 0; });
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    std::vector<path_result> run(const std::vector<path_query> &queries) {
+        std::vector<path_result> results;
+        run(queries, results);
+        return results;
+    }
+
+private:
+    void work(unsigned t) {
+        engine_type &engine = *engines_[t];
+        const std::vector<path_query> &queries = *queries_;
+        std::vector<path_result> &results = *results_;
+        // an exception must not escape a pool thread, and run() may only
+        // leave once every worker is done with the batch
+        try {
+            for (;;) {
+                const std::size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+                if (i >= queries.size())
+                    break;
+                const path_query &q = queries[i];
+                path_result &r = results[i];
+                r.stats = astar_stats();
+                engine.search(q.first.x, q.first.y, q.second.x, q.second.y, r.path, &r.stats);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+            next_.store(queries.size(), std::memory_order_relaxed);
+        }
+    }
+
+    void stop_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (std::thread &th : pool_)
+            th.join();
+    }
+
+    void worker_loop(unsigned t) {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [&] { return stop_ || batch_ != seen; });
+                if (stop_)
+                    return;
+                seen = batch_;
+            }
+            work(t);
+            // the lock publishes this worker's results to run()
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--busy_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    std::vector<std::unique_ptr<engine_type>> engines_;
+    std::vector<std::thread> pool_;
+
+    std::mutex mutex_;
+    std::condition_variable start_, done_;
+    unsigned batch_ = 0;
+    unsigned busy_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_; // first exception of the current batch
+
+    const std::vector<path_query> *queries_ = nullptr;
+    std::vector<path_result> *results_ = nullptr;
+    std::atomic<std::size_t> next_{0};
+};
+
+typedef BasicBatchAStar<FlatGrid> BatchAStar;
+
+#endif /* ASTAR_BATCH_H */
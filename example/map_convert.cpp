@@ -0,0 +1,53 @@
+// Converts a map to the tiled format of tiled_map.h.
+//
+//   map_convert input.bin|input.map output.tmap
+//
+// The input is the example's .bin format or a Moving AI .map file, chosen
+// by extension. The output is mapped back and compared cell by cell before
+// the tool reports success.
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "astar.h"
+#include "tiled_map.h"
+
+static bool ends_with(const std::string &s, const char *suffix) {
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " input.bin|input.map output.tmap" << std::endl;
+        return 2;
+    }
+    const std::string in_path = argv[1], out_path = argv[2];
+    grid_map map;
+    int L = 0, W = 0;
+    bool ok = ends_with(in_path, ".bin") ? load_bin_map(in_path, map, L, W) : load_movingai_map(in_path, map, L, W);
+    if (!ok) {
+        std::cerr << "Unable to read map: " << in_path << std::endl;
+        return 1;
+    }
+    if (!write_tiled_map(out_path, map, L, W)) {
+        std::cerr << "Unable to write " << out_path << std::endl;
+        return 1;
+    }
+    try {
+        TiledGrid check(out_path);
+        for (int y = 0; y < W; ++y)
+            for (int x = 0; x < L; ++x)
+                if (check.blocked(x, y) != (map[y][x] != 0)) {
+                    std::cerr << out_path << " differs from " << in_path << " at (" << x << ", " << y << ")"
+                              << std::endl;
+                    return 1;
+                }
+        std::cout << in_path << " -> " << out_path << ": " << L << " x " << W << ", "
+                  << check.data_bytes() << " bytes of tiles" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+#ifndef TILED_MAP_H
+#define TILED_MAP_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "astar.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TILED_MAP_HAS_MMAP 1
+#else
+#define TILED_MAP_HAS_MMAP 0
+#endif
+
+// Tiled map files (.tmap): a 64-byte header followed by the passability grid,
+// one bit per cell (1 = obstacle), in 8 x 8 tiles of one 64-bit word each.
+// Cell (x, y) is bit (y % 8) * 8 + x % 8 of tile (y / 8) * tiles_x + x / 8, so
+// a cell and its eight neighbours span at most four words, usually one.
+// Cells past the right and bottom edges of the map are stored as obstacles.
+// Words are in the byte order of the machine that wrote the file; byte_order
+// tells a reader with the other order to reject it.
+struct tiled_map_header {
+    char magic[8];            // "TILEMAP" and a NUL
+    std::uint32_t version;    // tiled_map_version
+    std::uint32_t byte_order; // 0x01020304 as written by the host
+    std::uint32_t width;      // columns (L)
+    std::uint32_t height;     // rows (W)
+    std::uint32_t tiles_x;    // (width + 7) / 8
+    std::uint32_t tiles_y;    // (height + 7) / 8
+    std::uint64_t data_offset; // start of the tiles, from the start of the file
+    std::uint64_t data_bytes;  // tiles_x * tiles_y * 8
+    std::uint8_t reserved[16];
+};
+static_assert(sizeof(tiled_map_header) == 64, "the tiled map header is 64 bytes");
+
+const std::uint32_t tiled_map_version = 1;
+
+// A grid map in the tiled format, either built in memory from a grid_map or
+// mapped read-only from a .tmap file. A mapped grid is ready as soon as the
+// header is checked: pages are read on first touch, and processes mapping
+// the same file share them. Like FlatGrid it can back any number of
+// BasicGridAStar<TiledGrid> engines at once; each engine commits search
+// state only for the blocks of cells its queries reach. Width and height
+// must each fit an int; the number of cells may exceed INT_MAX.
+class TiledGrid {
+public:
+    TiledGrid(const grid_map &map, int L, int W) {
+        init(static_cast<std::uint32_t>(L), static_cast<std::uint32_t>(W));
+        owned_.assign(static_cast<std::size_t>(tiles_x_) * tiles_y_, ~std::uint64_t(0));
+        for (int y = 0; y < W; ++y)
+            for (int x = 0; x < L; ++x)
+                if (map[y][x] == 0)
+                    owned_[tile(x, y)] &= ~bit(x, y);
+        tiles_ = owned_.data();
+    }
+
+    // Maps a .tmap file; throws std::runtime_error if it cannot be read or
+    // is not a tiled map this code understands.
+    explicit TiledGrid(const std::string &path) {
+#if TILED_MAP_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open tiled map " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(tiled_map_header)) {
+            ::close(fd);
+            throw std::runtime_error("not a tiled map: " + path);
+        }
+        mapping_size_ = static_cast<std::size_t>(st.st_size);
+        mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            throw std::runtime_error("cannot map tiled map " + path);
+        }
+        try {
+            attach(static_cast<const char *>(mapping_), mapping_size_, path);
+        } catch (...) {
+            ::munmap(mapping_, mapping_size_);
+            throw;
+        }
+#else
+        // no mmap: read the words into memory instead
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        tiled_map_header header;
+        if (!in || !in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            throw std::runtime_error("cannot read tiled map " + path);
+        check_header(header, UINT64_MAX, path);
+        owned_.resize(static_cast<std::size_t>(header.data_bytes / sizeof(std::uint64_t)));
+        in.seekg(static_cast<std::streamoff>(header.data_offset));
+        if (!in.read(reinterpret_cast<char *>(owned_.data()), static_cast<std::streamsize>(header.data_bytes)))
+            throw std::runtime_error("truncated tiled map: " + path);
+        init(header.width, header.height);
+        tiles_ = owned_.data();
+#endif
+    }
+
+    TiledGrid(const TiledGrid &) = delete;
+    TiledGrid &operator=(const TiledGrid &) = delete;
+
+    ~TiledGrid() {
+#if TILED_MAP_HAS_MMAP
+        if (mapping_)
+            ::munmap(mapping_, mapping_size_);
+#endif
+    }
+
+    int width() const { return static_cast<int>(width_); }
+    int height() const { return static_cast<int>(height_); }
+    std::size_t cells() const { return static_cast<std::size_t>(width_) * height_; }
+
+    // true if the tiles live in a file mapping rather than on the heap
+    bool mapped() const { return mapping_ != nullptr; }
+
+    bool blocked(int x, int y) const {
+        return (tiles_[tile(x, y)] & bit(x, y)) != 0;
+    }
+
+    // the tiles as they are stored in the file
+    const std::uint64_t *data() const { return tiles_; }
+    std::size_t data_bytes() const { return static_cast<std::size_t>(tiles_x_) * tiles_y_ * sizeof(std::uint64_t); }
+
+private:
+    void init(std::uint32_t width, std::uint32_t height) {
+        width_ = width;
+        height_ = height;
+        tiles_x_ = (width + 7) / 8;
+        tiles_y_ = (height + 7) / 8;
+    }
+
+    std::size_t tile(int x, int y) const {
+        return static_cast<std::size_t>(y >> 3) * tiles_x_ + static_cast<std::size_t>(x >> 3);
+    }
+
+    static std::uint64_t bit(int x, int y) {
+        return std::uint64_t(1) << (((y & 7) << 3) | (x & 7));
+    }
+
+    static void check_header(const tiled_map_header &h, std::uint64_t file_bytes, const std::string &path) {
+        if (std::memcmp(h.magic, "TILEMAP", 8) != 0)
+            throw std::runtime_error("not a tiled map: " + path);
+        if (h.byte_order != 0x01020304u)
+            throw std::runtime_error("tiled map written with the other byte order: " + path);
+        if (h.version != tiled_map_version)
+            throw std::runtime_error("unsupported tiled map version " + std::to_string(h.version) + ": " + path);
+        if (h.width > INT_MAX || h.height > INT_MAX || h.tiles_x != (h.width + 7) / 8 ||
+            h.tiles_y != (h.height + 7) / 8 ||
+            h.data_bytes != static_cast<std::uint64_t>(h.tiles_x) * h.tiles_y * sizeof(std::uint64_t) ||
+            h.data_offset % sizeof(std::uint64_t) != 0)
+            throw std::runtime_error("corrupt tiled map header: " + path);
+        if (h.data_offset > file_bytes || h.data_bytes > file_bytes - h.data_offset)
+            throw std::runtime_error("truncated tiled map: " + path);
+    }
+
+    void attach(const char *base, std::size_t bytes, const std::string &path) {
+        tiled_map_header header;
+        std::memcpy(&header, base, sizeof(header));
+        check_header(header, bytes, path);
+        init(header.width, header.height);
+        tiles_ = reinterpret_cast<const std::uint64_t *>(base + header.data_offset);
+    }
+
+    std::uint32_t width_ = 0, height_ = 0;
+    std::uint32_t tiles_x_ = 0, tiles_y_ = 0;
+    const std::uint64_t *tiles_ = nullptr;
+    std::vector<std::uint64_t> owned_;
+    void *mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+};
+
+inline void write_tiled_map(std::ostream &out, const TiledGrid &grid) {
+    tiled_map_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "TILEMAP", 8);
+    header.version = tiled_map_version;
+    header.byte_order = 0x01020304u;
+    header.width = static_cast<std::uint32_t>(grid.width());
+    header.height = static_cast<std::uint32_t>(grid.height());
+    header.tiles_x = (header.width + 7) / 8;
+    header.tiles_y = (header.height + 7) / 8;
+    header.data_offset = sizeof(header);
+    header.data_bytes = grid.data_bytes();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(grid.data()), static_cast<std::streamsize>(grid.data_bytes()));
+}
+
+inline bool write_tiled_map(const std::string &path, const grid_map &map, int L, int W) {
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    write_tiled_map(out, TiledGrid(map, L, W));
+    return static_cast<bool>(out.flush());
+}
+
+typedef BasicGridAStar<TiledGrid> TiledGridAStar;
+
+#endif /* TILED_MAP_H */
@@ -0,0 +1,159 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _INDEXED_RP_HEAP_H_
+#define _INDEXED_RP_HEAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "intrusive_rp_heap.h"
+
+/// Priority queue over the dense id universe [0, n), e.g. grid cells or
+/// graph vertices.
+///
+/// A slab of n slots is allocated up front; slot id holds the key and the
+/// heap links for id, so the slab is also the id -> node table. push(),
+/// decrease(), pop() and erase() touch no hash table and never allocate;
+/// the links are intrusive_rp_heap's, so the algorithm is rp_heap's.
+template <class _Kty, class _Pr = std::less<_Kty>>
+class indexed_rp_heap
+{
+public:
+    typedef _Kty key_type;
+    typedef _Pr key_compare;
+    typedef std::size_t size_type;
+    typedef std::size_t id_type;
+
+    explicit indexed_rp_heap(size_type _Count, const _Pr& _Pred = _Pr())
+        : comp(_Pred), _Myslab(_Count), _Myheap(_Slot_compare(_Pred))
+    {
+    }
+
+    indexed_rp_heap(const indexed_rp_heap&) = delete;
+    indexed_rp_heap& operator=(const indexed_rp_heap&) = delete;
+
+    bool empty() const
+    {
+        return _Myheap.empty();
+    }
+
+    size_type size() const
+    {
+        return _Myheap.size();
+    }
+
+    // size of the id universe
+    size_type capacity() const
+    {
+        return _Myslab.size();
+    }
+
+    bool contains(id_type _Id) const
+    {
+        return _Myslab[_Id]._Hook.is_linked();
+    }
+
+    // key of an id in the heap
+    const key_type& key(id_type _Id) const
+    {
+        return _Myslab[_Id]._Key;
+    }
+
+    id_type top() const
+    {
+        return _Id_of(_Myheap.top());
+    }
+
+    const key_type& top_key() const
+    {
+        return _Myheap.top()._Key;
+    }
+
+    void push(id_type _Id, const key_type& _Key)
+    {
+        if (contains(_Id))
+            throw std::invalid_argument("push error: id already in the heap");
+        _Myslab[_Id]._Key = _Key;
+        _Myheap.push(_Myslab[_Id]);
+    }
+
+    id_type pop()
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        id_type _Id = top();
+        _Myheap.pop();
+        return _Id;
+    }
+
+    // lower the key of an id in the heap; a key that is not smaller is
+    // ignored, as in rp_heap::decrease
+    void decrease(id_type _Id, const key_type& _Key)
+    {
+        _Slot& _S = _Myslab[_Id];
+        if (!comp(_Key, _S._Key))
+            return;
+        _S._Key = _Key;
+        _Myheap.decrease(_S);
+    }
+
+    void erase(id_type _Id)
+    {
+        _Myheap.erase(_Myslab[_Id]);
+    }
+
+    // O(size()): unlinks the ids still in the heap, the slab is kept
+    void clear()
+    {
+        _Myheap.clear();
+    }
+
+private:
+    struct _Slot
+    {
+        _Kty _Key;
+        rp_heap_hook<_Slot> _Hook;
+    };
+
+    struct _Slot_compare
+    {
+        _Slot_compare(const _Pr& _Pred) : comp(_Pred)
+        {
+        }
+        bool operator()(const _Slot& _Left, const _Slot& _Right) const
+        {
+            return comp(_Left._Key, _Right._Key);
+        }
+        _Pr comp;
+    };
+
+    id_type _Id_of(const _Slot& _S) const
+    {
+        return static_cast<id_type>(&_S - _Myslab.data());
+    }
+
+    _Pr comp;
+    std::vector<_Slot> _Myslab;
+    intrusive_rp_heap<_Slot, &_Slot::_Hook, _Slot_compare> _Myheap;
+};
+
+#endif /* _INDEXED_RP_HEAP_H_ */
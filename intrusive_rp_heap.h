@@ -0,0 +1,232 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _INTRUSIVE_RP_HEAP_H_
+#define _INTRUSIVE_RP_HEAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+
+#include "rp_heap_core.h"
+
+// rank-pairing heap over objects the caller owns: the links live in an
+// rp_heap_hook member of the element type, so push/pop/decrease/erase never
+// allocate and the object itself is the decrease-key handle. Same algorithm
+// as rp_heap, run by the shared core, and the same _Stats and _Pass policies.
+
+template <class _Ty>
+struct rp_heap_hook
+{
+    rp_heap_hook()
+    {
+        _Reset();
+    }
+    // hooks are not copied along with their object: a copy starts unlinked
+    rp_heap_hook(const rp_heap_hook&) : rp_heap_hook()
+    {
+    }
+    rp_heap_hook& operator=(const rp_heap_hook&)
+    {
+        return *this;
+    }
+    // a root is in the circular root list (_Next set), any other node has
+    // a parent
+    bool is_linked() const
+    {
+        return _Parent != nullptr || _Next != nullptr;
+    }
+    void _Reset()
+    {
+        _Left = _Next = _Parent = nullptr;
+        _Rank = 0;
+    }
+    _Ty* _Left;
+    _Ty* _Next;
+    _Ty* _Parent;
+    int _Rank;
+};
+
+template <class _Ty, rp_heap_hook<_Ty> _Ty::*_Hook, class _Pr = std::less<_Ty>,
+          class _Stats = rp_heap_no_stats, class _Pass = rp_heap_multipass>
+class intrusive_rp_heap : private _Stats_base<_Stats>
+{
+public:
+    typedef _Ty* _Nodeptr;
+    typedef _Pr key_compare;
+    typedef _Ty value_type;
+    typedef _Ty& reference;
+    typedef std::size_t size_type;
+    typedef _Stats stats_policy;
+    typedef _Pass consolidation_policy;
+
+    intrusive_rp_heap(const _Pr& _Pred = _Pr()) : comp(_Pred)
+    {
+        _Mysize = 0;
+        _Myhead = nullptr;
+    }
+
+    intrusive_rp_heap(const intrusive_rp_heap&) = delete;
+    intrusive_rp_heap& operator=(const intrusive_rp_heap&) = delete;
+
+    // the elements are not destroyed, only unlinked
+    ~intrusive_rp_heap()
+    {
+        clear();
+    }
+
+    bool empty() const
+    {
+        return _Mysize == 0;
+    }
+
+    size_type size() const
+    {
+        return _Mysize;
+    }
+
+    reference top() const
+    {
+        return *_Myhead;
+    }
+
+    // link _Obj into the heap; it must not be in a heap already and must
+    // stay at its address until popped or erased
+    void push(_Ty& _Obj)
+    {
+        _Algo::_Insert_root(_Nodes(), _Myhead, &_Obj);
+        _Mysize++;
+    }
+
+    void pop()
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Nodeptr _Ptr = _Algo::_Unlink_head(_Nodes(), _Myhead, _Mybucket, _Mysize);
+        _Hk(_Ptr)._Reset();
+        _Mysize--;
+    }
+
+    // restore the heap order after the caller lowered _Obj's key
+    void decrease(_Ty& _Obj)
+    {
+        _Nodeptr _Ptr = &_Obj;
+        if (_Ptr == _Myhead)
+            return;
+        if (_Hk(_Ptr)._Parent == nullptr) //one of the roots
+        {
+            if (_Algo::_Less(_Nodes(), _Ptr, _Myhead))
+                _Myhead = _Ptr;
+        }
+        else
+        {
+            _Algo::_Cut(_Nodes(), _Ptr);
+            _Algo::_Insert_root(_Nodes(), _Myhead, _Ptr);
+        }
+    }
+
+    // unlink an arbitrary element; to raise a key, erase and push again
+    void erase(_Ty& _Obj)
+    {
+        _Algo::_Unlink(_Nodes(), _Myhead, _Mybucket, _Mysize, &_Obj);
+        _Mysize--;
+    }
+
+    // unlink every element, threading the pending nodes through their
+    // _Parent fields so that no workspace is needed
+    void clear()
+    {
+        if (empty())
+            return;
+        _Nodeptr _Pending = nullptr;
+        _Nodeptr _Ptr = _Myhead;
+        do
+        {
+            _Nodeptr _NextPtr = _Hk(_Ptr)._Next;
+            _Hk(_Ptr)._Next = nullptr;
+            _Hk(_Ptr)._Parent = _Pending;
+            _Pending = _Ptr;
+            _Ptr = _NextPtr;
+        } while (_Ptr != _Myhead);
+        while (_Pending)
+        {
+            _Ptr = _Pending;
+            _Pending = _Hk(_Ptr)._Parent;
+            if (_Hk(_Ptr)._Left)
+            {
+                _Hk(_Hk(_Ptr)._Left)._Parent = _Pending;
+                _Pending = _Hk(_Ptr)._Left;
+            }
+            if (_Hk(_Ptr)._Next)
+            {
+                _Hk(_Hk(_Ptr)._Next)._Parent = _Pending;
+                _Pending = _Hk(_Ptr)._Next;
+            }
+            _Hk(_Ptr)._Reset();
+        }
+        _Myhead = nullptr;
+        _Mysize = 0;
+    }
+
+    // operation counters collected by the _Stats policy (all zero with the
+    // default rp_heap_no_stats)
+    rp_heap_stats stats() const
+    {
+        return this->_Get_stats().snapshot();
+    }
+
+    void reset_stats()
+    {
+        this->_Get_stats().reset();
+    }
+
+private:
+    static rp_heap_hook<_Ty>& _Hk(_Nodeptr _Ptr)
+    {
+        return _Ptr->*_Hook;
+    }
+
+    // the node access the shared core runs on: links live in the hooks
+    struct _Node_access
+    {
+        typedef _Ty* _Nodeptr;
+        const intrusive_rp_heap* _Heap;
+
+        _Nodeptr nil() const { return nullptr; }
+        _Nodeptr& left(_Nodeptr _Ptr) const { return _Hk(_Ptr)._Left; }
+        _Nodeptr& next(_Nodeptr _Ptr) const { return _Hk(_Ptr)._Next; }
+        _Nodeptr& parent(_Nodeptr _Ptr) const { return _Hk(_Ptr)._Parent; }
+        int& rank(_Nodeptr _Ptr) const { return _Hk(_Ptr)._Rank; }
+        bool less(_Nodeptr _Left, _Nodeptr _Right) const { return _Heap->comp(*_Left, *_Right); }
+        _Stats& stats() const { return _Heap->_Get_stats(); }
+    };
+    typedef _Rp_algo<_Node_access, _Pass> _Algo;
+
+    _Node_access _Nodes() const
+    {
+        return _Node_access{this};
+    }
+
+    _Pr comp;
+    _Nodeptr _Myhead;
+    size_type _Mysize;
+    _Rp_fixed_bucket<_Nodeptr> _Mybucket; // rank buckets, all null between pops
+};
+
+#endif /* _INTRUSIVE_RP_HEAP_H_ */
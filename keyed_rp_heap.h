@@ -0,0 +1,222 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _KEYED_RP_HEAP_H_
+#define _KEYED_RP_HEAP_H_
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rp_heap.h"
+
+/// Key type a keyed_rp_heap caches: what _KeyFn returns for a value.
+template <class _Ty, class _KeyFn>
+struct _Keyed_key
+{
+    typedef typename std::decay<decltype(std::declval<const _KeyFn&>()(std::declval<const _Ty&>()))>::type type;
+};
+
+/// Element of the rp_heap inside a keyed_rp_heap: the key comes first, so in
+/// the node it sits next to the value and the links.
+template <class _Key, class _Ty>
+struct _Keyed_value
+{
+    template <class _Arg>
+    _Keyed_value(const _Key& _K, _Arg&& _V) : _Key_val(_K), _Val(std::forward<_Arg>(_V))
+    {
+    }
+    _Key _Key_val;
+    _Ty _Val;
+};
+
+/// Orders _Keyed_value elements by their cached keys alone.
+template <class _Key, class _Ty, class _KeyCmp>
+struct _Keyed_compare
+{
+    _Keyed_compare(const _KeyCmp& _Cmp = _KeyCmp()) : comp(_Cmp)
+    {
+    }
+    bool operator()(const _Keyed_value<_Key, _Ty>& _Left, const _Keyed_value<_Key, _Ty>& _Right) const
+    {
+        return comp(_Left._Key_val, _Right._Key_val);
+    }
+    _KeyCmp comp;
+};
+
+/// rp_heap that caches each element's key in its node.
+///
+/// push() evaluates _KeyFn once and stores the key beside the links, so
+/// _Link and _Insert_root compare cached keys and never touch the value.
+/// This suits pointer payloads such as A*'s AstarNode*, where comparing
+/// through the pointer would miss the cache on every comparison.
+/// decrease() takes the new key directly; the value is left alone, so the
+/// caller need not (and should not) rely on _KeyFn seeing the new key.
+template <class _Ty, class _KeyFn, class _KeyCmp = std::less<typename _Keyed_key<_Ty, _KeyFn>::type>,
+          class _Alloc = std::allocator<_Ty>, class _Stats = rp_heap_no_stats, class _Pass = rp_heap_multipass>
+class keyed_rp_heap
+{
+public:
+    typedef typename _Keyed_key<_Ty, _KeyFn>::type key_type;
+    typedef _Keyed_value<key_type, _Ty> _Elem;
+    typedef rp_heap<_Elem, _Keyed_compare<key_type, _Ty, _KeyCmp>,
+                    typename std::allocator_traits<_Alloc>::template rebind_alloc<_Elem>, _Stats, _Pass> heap_type;
+
+    typedef _KeyFn key_function;
+    typedef _KeyCmp key_compare;
+    typedef _Alloc allocator_type;
+    typedef _Ty value_type;
+    typedef const value_type& const_reference;
+    typedef const value_type* const_pointer;
+    typedef typename heap_type::size_type size_type;
+
+    // handle returned by push: dereferences to the value, key() reads the
+    // cached key
+    class const_iterator
+    {
+    public:
+        friend keyed_rp_heap;
+
+        const_iterator()
+        {
+        }
+        const_reference operator*() const
+        {
+            return _It->_Val;
+        }
+        const_pointer operator->() const
+        {
+            return &(operator*());
+        }
+        const key_type& key() const
+        {
+            return _It->_Key_val;
+        }
+
+    private:
+        const_iterator(typename heap_type::const_iterator _Inner) : _It(_Inner)
+        {
+        }
+        typename heap_type::const_iterator _It;
+    };
+
+    explicit keyed_rp_heap(const _KeyFn& _Fn = _KeyFn(), const _KeyCmp& _Cmp = _KeyCmp())
+        : key(_Fn), comp(_Cmp), _Myheap(_Keyed_compare<key_type, _Ty, _KeyCmp>(_Cmp))
+    {
+    }
+
+    keyed_rp_heap(const keyed_rp_heap&) = delete;
+    keyed_rp_heap& operator=(const keyed_rp_heap&) = delete;
+
+    bool empty() const
+    {
+        return _Myheap.empty();
+    }
+
+    size_type size() const
+    {
+        return _Myheap.size();
+    }
+
+    const_reference top() const
+    {
+        return _Myheap.top()._Val;
+    }
+
+    const key_type& top_key() const
+    {
+        return _Myheap.top()._Key_val;
+    }
+
+    const_iterator push(const value_type& _Val)
+    {
+        return const_iterator(_Myheap.push(_Elem(key(_Val), _Val)));
+    }
+
+    const_iterator push(value_type&& _Val)
+    {
+        key_type _Key = key(_Val);
+        return const_iterator(_Myheap.push(_Elem(_Key, std::move(_Val))));
+    }
+
+    void pop()
+    {
+        _Myheap.pop();
+    }
+
+    void pop(value_type& _Val)
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Val = std::move(const_cast<_Elem&>(_Myheap.top())._Val);
+        _Myheap.pop();
+    }
+
+    // lower the cached key to _Key; a key that is not smaller is ignored,
+    // as in rp_heap::decrease
+    void decrease(const_iterator _Where, const key_type& _Key)
+    {
+        _Elem& _E = _Where._It._Ptr->_Val;
+        if (!comp(_Key, _E._Key_val))
+            return;
+        // write the key in place and let rp_heap restore the order around
+        // the node; it compares _E with itself, so nothing is copied
+        _E._Key_val = _Key;
+        _Myheap.decrease(_Where._It, _E);
+    }
+
+    void erase(const_iterator _Where)
+    {
+        _Myheap.erase(_Where._It);
+    }
+
+    void clear()
+    {
+        _Myheap.clear();
+    }
+
+    void reserve(size_type _Count)
+    {
+        _Myheap.reserve(_Count);
+    }
+
+    void shrink_to_fit()
+    {
+        _Myheap.shrink_to_fit();
+    }
+
+    rp_heap_stats stats() const
+    {
+        return _Myheap.stats();
+    }
+
+    void reset_stats()
+    {
+        _Myheap.reset_stats();
+    }
+
+private:
+    _KeyFn key;
+    _KeyCmp comp;
+    heap_type _Myheap;
+};
+
+#endif /* _KEYED_RP_HEAP_H_ */
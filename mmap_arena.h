@@ -0,0 +1,214 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MMAP_ARENA_H_
+#define MMAP_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "pool_allocator.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MMAP_ARENA_HAS_MMAP 1
+#else
+#define MMAP_ARENA_HAS_MMAP 0
+#endif
+
+/// Block source for pool_allocator that carves blocks out of large reserved
+/// address ranges instead of allocating each block separately.
+///
+/// Address space is reserved in regions with PROT_NONE, starting at
+/// RegionBytes and doubling for each new region, and is committed 2 MiB at a
+/// time as blocks are handed out. A heap of 100M nodes thus lives in a few
+/// mappings instead of hundreds of thousands of 4 KiB allocations. With
+/// HugePages, regions are aligned to 2 MiB and marked MADV_HUGEPAGE so the
+/// kernel can back them with transparent huge pages, which cuts TLB misses
+/// when pop() chases pointers across the heap.
+///
+/// Blocks given back by pool_allocator::trim() have their pages released
+/// with MADV_DONTNEED (splitting a huge page if needed) and are reused before
+/// fresh address space. All regions are unmapped when the pool is destroyed.
+/// Without mmap the arena falls back to ::operator new per block.
+///
+/// Template parameters:
+///   HugePages   - request transparent huge pages (default true)
+///   RegionBytes - size of the first reserved region (default 64 MiB)
+template <bool HugePages = true, std::size_t RegionBytes = (std::size_t(64) << 20)>
+class mmap_arena_block_source
+{
+public:
+    static constexpr bool releases_on_destroy = true;
+
+    mmap_arena_block_source() = default;
+    mmap_arena_block_source(const mmap_arena_block_source&) = delete;
+    mmap_arena_block_source& operator=(const mmap_arena_block_source&) = delete;
+
+    ~mmap_arena_block_source()
+    {
+#if MMAP_ARENA_HAS_MMAP
+        for (const Region& r : regions_)
+            ::munmap(r.base, r.size);
+#else
+        for (void* block : owned_)
+            ::operator delete(block);
+#endif
+    }
+
+    /// Every call must ask for the same size; pool_allocator always does.
+    void* allocate(std::size_t bytes)
+    {
+        if (!reusable_.empty())
+        {
+            void* block = reusable_.back();
+            reusable_.pop_back();
+            return block;
+        }
+        // any block handed out may come back, so make room for it now and
+        // deallocate() never has to grow reusable_
+        if (reusable_.capacity() == carved_)
+            reusable_.reserve(carved_ ? 2 * carved_ : 16);
+#if MMAP_ARENA_HAS_MMAP
+        std::size_t stride = (bytes + 63) & ~std::size_t(63);
+        if (stride > static_cast<std::size_t>(end_ - cursor_))
+            add_region(stride);
+        if (cursor_ + stride > committed_)
+            commit(cursor_ + stride);
+        void* block = cursor_;
+        cursor_ += stride;
+        ++carved_;
+        return block;
+#else
+        owned_.reserve(owned_.size() + 1);
+        void* block = ::operator new(bytes);
+        owned_.push_back(block);
+        ++carved_;
+        return block;
+#endif
+    }
+
+    /// Never throws: pool_allocator::trim() calls it midway through
+    /// relinking its blocks.
+    void deallocate(void* block, std::size_t bytes) noexcept
+    {
+#if MMAP_ARENA_HAS_MMAP && defined(MADV_DONTNEED)
+        // release the pages lying entirely inside the block
+        std::uintptr_t page = page_size();
+        std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(block) + page - 1) & ~(page - 1);
+        std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(block) + bytes) & ~(page - 1);
+        if (first < last)
+            ::madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+#else
+        (void)bytes;
+#endif
+        reusable_.push_back(block);
+    }
+
+    /// Bytes of address space reserved so far.
+    std::size_t reserved_bytes() const
+    {
+        std::size_t total = 0;
+#if MMAP_ARENA_HAS_MMAP
+        for (const Region& r : regions_)
+            total += r.size;
+#endif
+        return total;
+    }
+
+private:
+    static constexpr std::size_t huge_page = std::size_t(2) << 20;
+
+#if MMAP_ARENA_HAS_MMAP
+    struct Region
+    {
+        void* base;
+        std::size_t size;
+    };
+
+    static std::size_t page_size()
+    {
+        static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    // Reserves a new region with room for at least min_bytes. The rest of
+    // the previous region is abandoned.
+    void add_region(std::size_t min_bytes)
+    {
+        std::size_t size = regions_.empty() ? RegionBytes : regions_.back().size * 2;
+        while (size < min_bytes)
+            size *= 2;
+        size = (size + huge_page - 1) & ~(huge_page - 1);
+        std::size_t mapped = HugePages ? size + huge_page : size;
+        void* raw = ::mmap(nullptr, mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc();
+        char* base = static_cast<char*>(raw);
+        if (HugePages)
+        {
+            // trim the mapping to a 2 MiB aligned range
+            char* aligned = reinterpret_cast<char*>(
+                (reinterpret_cast<std::uintptr_t>(base) + huge_page - 1) & ~std::uintptr_t(huge_page - 1));
+            if (aligned != base)
+                ::munmap(base, aligned - base);
+            if (aligned + size != base + mapped)
+                ::munmap(aligned + size, base + mapped - (aligned + size));
+            base = aligned;
+        }
+        regions_.push_back({base, size});
+        cursor_ = committed_ = base;
+        end_ = base + size;
+    }
+
+    // Makes [committed_, up_to) readable and writable, rounding up to 2 MiB.
+    void commit(char* up_to)
+    {
+        std::size_t want = static_cast<std::size_t>(up_to - committed_);
+        want = (want + huge_page - 1) & ~(huge_page - 1);
+        if (want > static_cast<std::size_t>(end_ - committed_))
+            want = static_cast<std::size_t>(end_ - committed_);
+        if (::mprotect(committed_, want, PROT_READ | PROT_WRITE) != 0)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (HugePages)
+            ::madvise(committed_, want, MADV_HUGEPAGE);
+#endif
+        committed_ += want;
+    }
+
+    std::vector<Region> regions_;
+    char* cursor_ = nullptr;    // next block
+    char* committed_ = nullptr; // end of the committed part of the region
+    char* end_ = nullptr;       // end of the current region
+#else
+    std::vector<void*> owned_;
+#endif
+    std::vector<void*> reusable_; // blocks returned by deallocate()
+    std::size_t carved_ = 0;      // blocks ever handed out fresh
+};
+
+/// pool_allocator drawing its blocks from an mmap_arena_block_source.
+template <class T, std::size_t BlockSize = 4096, bool HugePages = true>
+using arena_pool_allocator = pool_allocator<T, BlockSize, mmap_arena_block_source<HugePages>>;
+
+#endif /* MMAP_ARENA_H_ */
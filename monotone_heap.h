@@ -0,0 +1,350 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _MONOTONE_HEAP_H_
+#define _MONOTONE_HEAP_H_
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rp_heap.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/// Key function for monotone_heap when the values are the keys.
+struct monotone_identity
+{
+    template <class _Ty>
+    const _Ty& operator()(const _Ty& _Val) const
+    {
+        return _Val;
+    }
+};
+
+/// Radix heap for monotone workloads with unsigned integer keys.
+///
+/// Offers rp_heap's push/top/pop/decrease interface with the same stable
+/// const_iterator handles, so Dijkstra-style code can switch between the two
+/// by changing the heap type. _KeyFn maps a value to its unsigned key; a
+/// comparator such as sssp.h's by_distance can serve as both, by providing
+/// operator()(a, b) for rp_heap and operator()(v) for this heap.
+///
+/// Keys must be monotone: push() and decrease() may not go below the key
+/// last returned by pop() (std::invalid_argument otherwise). In exchange,
+/// there are no comparisons between elements. An element lives in bucket
+/// bit_width(key ^ last) and moves to a lower bucket only when the buckets
+/// below it run empty, so each element moves at most once per key bit.
+/// Each node caches its key, so a key read through _KeyFn from external
+/// state (dist[v]) may change before the matching decrease() call.
+template <class _Ty, class _KeyFn = monotone_identity, class _Alloc = std::allocator<_Ty>>
+class monotone_heap
+{
+public:
+    typedef monotone_heap<_Ty, _KeyFn, _Alloc> _Myt;
+    typedef typename std::decay<decltype(std::declval<const _KeyFn&>()(std::declval<const _Ty&>()))>::type key_type;
+    static_assert(std::is_integral<key_type>::value && std::is_unsigned<key_type>::value,
+                  "monotone_heap keys must be unsigned integers");
+
+    struct _Node
+    {
+        template <class _Arg>
+        _Node(_Arg&& _Right, key_type _Key) : _Val(std::forward<_Arg>(_Right)), _Key(_Key)
+        {
+            _Prev = _Next = nullptr;
+            _Bucket = 0;
+        }
+        _Ty _Val;
+        key_type _Key;
+        _Node* _Prev;
+        _Node* _Next;
+        unsigned _Bucket;
+    };
+    typedef _Node* _Nodeptr;
+
+    typedef _KeyFn key_function;
+    typedef _Alloc allocator_type;
+    typedef std::allocator_traits<_Alloc> _Alloc_traits;
+    typedef typename _Alloc_traits::template rebind_alloc<_Node> _Alty;
+    typedef std::allocator_traits<_Alty> _Alty_traits;
+    typedef typename _Alloc_traits::value_type value_type;
+    typedef typename _Alloc_traits::pointer pointer;
+    typedef typename _Alloc_traits::const_pointer const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename _Alloc_traits::difference_type difference_type;
+    typedef typename _Alloc_traits::size_type size_type;
+
+    typedef _Iterator<_Myt> const_iterator;
+
+    explicit monotone_heap(const _KeyFn& _Fn = _KeyFn()) : key(_Fn)
+    {
+        _Mysize = 0;
+        _Mylast = 0;
+        _Mymin = nullptr;
+        for (_Nodeptr& _Ptr : _Mybucket)
+            _Ptr = nullptr;
+    }
+
+    monotone_heap(const monotone_heap&) = delete;
+    monotone_heap& operator=(const monotone_heap&) = delete;
+
+    ~monotone_heap()
+    {
+        clear();
+    }
+
+    bool empty() const
+    {
+        return _Mysize == 0;
+    }
+
+    size_type size() const
+    {
+        return _Mysize;
+    }
+
+    // the key last returned by pop(); no smaller key may be inserted
+    key_type last_key() const
+    {
+        return _Mylast;
+    }
+
+    // finds the minimum without moving any node, so calling it does not
+    // change last_key() or which keys push() accepts
+    const_reference top() const
+    {
+        return _Find_min()->_Val;
+    }
+
+    const_iterator push(const value_type& _Val)
+    {
+        return _Push(_Val);
+    }
+
+    const_iterator push(value_type&& x)
+    {
+        return _Push(std::move(x));
+    }
+
+    void pop()
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Settle();
+        _Nodeptr _Ptr = _Mybucket[0];
+        if (_Ptr == _Mymin)
+            _Mymin = nullptr;
+        _Remove(_Ptr);
+        _Freenode(_Ptr);
+    }
+
+    void pop(value_type& _Val)
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Settle();
+        _Val = std::move(_Mybucket[0]->_Val);
+        pop();
+    }
+
+    // lower the element's key to key(_Val); a value whose key is not smaller
+    // than the cached one is ignored, as in rp_heap::decrease
+    void decrease(const_iterator _It, const value_type& _Val)
+    {
+        _Nodeptr _Ptr = _It._Ptr;
+        key_type _Key = key(_Val);
+        if (!(_Key < _Ptr->_Key))
+            return;
+        _Check_monotone(_Key);
+        _Ptr->_Val = _Val;
+        _Ptr->_Key = _Key;
+        unsigned _Index = _Bucket_index(_Key);
+        if (_Index != _Ptr->_Bucket)
+        {
+            _Remove(_Ptr);
+            _Insert(_Ptr, _Index);
+        }
+        _Note_key(_Ptr);
+    }
+
+    void clear()
+    {
+        for (_Nodeptr& _Head : _Mybucket)
+        {
+            for (_Nodeptr _Ptr = _Head; _Ptr; )
+            {
+                _Nodeptr _NextPtr = _Ptr->_Next;
+                _Freenode(_Ptr);
+                _Ptr = _NextPtr;
+            }
+            _Head = nullptr;
+        }
+        _Mylast = 0;
+        _Mymin = nullptr;
+    }
+
+private:
+    static constexpr unsigned _Bits = std::numeric_limits<key_type>::digits;
+
+    template <class _Arg>
+    const_iterator _Push(_Arg&& _Val)
+    {
+        key_type _Key = key(_Val);
+        _Check_monotone(_Key);
+        _Nodeptr _Ptr = _Alty_traits::allocate(_Alnod, 1);
+        try
+        {
+            _Alty_traits::construct(_Alnod, _Ptr, std::forward<_Arg>(_Val), _Key);
+        }
+        catch (...)
+        {
+            _Alty_traits::deallocate(_Alnod, _Ptr, 1);
+            throw;
+        }
+        _Insert(_Ptr, _Bucket_index(_Key));
+        _Mysize++;
+        _Note_key(_Ptr);
+        return const_iterator(_Ptr);
+    }
+
+    void _Check_monotone(key_type _Key) const
+    {
+        if (_Key < _Mylast)
+            throw std::invalid_argument("monotone_heap: key below the last popped key");
+    }
+
+    // 0 for keys equal to the last popped key, otherwise the position of the
+    // highest bit in which they differ, plus one
+    unsigned _Bucket_index(key_type _Key) const
+    {
+        key_type _Diff = _Key ^ _Mylast;
+        if (_Diff == 0)
+            return 0;
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(std::numeric_limits<unsigned long long>::digits
+            - __builtin_clzll(static_cast<unsigned long long>(_Diff)));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long _Index;
+        _BitScanReverse64(&_Index, static_cast<unsigned long long>(_Diff));
+        return static_cast<unsigned>(_Index) + 1;
+#else
+        unsigned _Width = 0;
+        while (_Diff)
+        {
+            _Diff >>= 1;
+            _Width++;
+        }
+        return _Width;
+#endif
+    }
+
+    void _Insert(_Nodeptr _Ptr, unsigned _Index)
+    {
+        _Ptr->_Bucket = _Index;
+        _Ptr->_Prev = nullptr;
+        _Ptr->_Next = _Mybucket[_Index];
+        if (_Ptr->_Next)
+            _Ptr->_Next->_Prev = _Ptr;
+        _Mybucket[_Index] = _Ptr;
+    }
+
+    void _Remove(_Nodeptr _Ptr)
+    {
+        if (_Ptr->_Prev)
+            _Ptr->_Prev->_Next = _Ptr->_Next;
+        else
+            _Mybucket[_Ptr->_Bucket] = _Ptr->_Next;
+        if (_Ptr->_Next)
+            _Ptr->_Next->_Prev = _Ptr->_Prev;
+    }
+
+    // the node with the smallest key: bucket 0 if it is not empty, otherwise
+    // the smallest key of the lowest non-empty bucket, found by a scan whose
+    // result is kept in _Mymin until the next pop
+    _Nodeptr _Find_min() const
+    {
+        if (_Mybucket[0] != nullptr)
+            return _Mybucket[0];
+        if (_Mymin == nullptr)
+        {
+            unsigned _Index = 1;
+            while (_Mybucket[_Index] == nullptr)
+                _Index++;
+            _Mymin = _Mybucket[_Index];
+            for (_Nodeptr _Ptr = _Mymin->_Next; _Ptr; _Ptr = _Ptr->_Next)
+                if (_Ptr->_Key < _Mymin->_Key)
+                    _Mymin = _Ptr;
+        }
+        return _Mymin;
+    }
+
+    // keep a found minimum current when _Ptr gets a key
+    void _Note_key(_Nodeptr _Ptr)
+    {
+        if (_Mymin != nullptr && _Ptr->_Key < _Mymin->_Key)
+            _Mymin = _Ptr;
+    }
+
+    // make bucket 0 hold the minimum: take the lowest non-empty bucket, raise
+    // the last key to its smallest key and spread its nodes over the buckets
+    // below. Only pop() calls this, right before it removes that minimum, so
+    // _Mylast is always the key last returned by pop()
+    void _Settle()
+    {
+        if (_Mybucket[0] != nullptr)
+            return;
+        _Nodeptr _Min = _Find_min();
+        unsigned _Index = _Min->_Bucket;
+        _Nodeptr _List = _Mybucket[_Index];
+        _Mybucket[_Index] = nullptr;
+        _Mylast = _Min->_Key;
+        _Mymin = nullptr;
+        for (_Nodeptr _Ptr = _List; _Ptr; )
+        {
+            _Nodeptr _NextPtr = _Ptr->_Next;
+            _Insert(_Ptr, _Bucket_index(_Ptr->_Key));
+            _Ptr = _NextPtr;
+        }
+    }
+
+    void _Freenode(_Nodeptr _Ptr)
+    {
+        _Alty_traits::destroy(_Alnod, _Ptr);
+        _Alty_traits::deallocate(_Alnod, _Ptr, 1);
+        _Mysize--;
+    }
+
+    _KeyFn key;
+    size_type _Mysize;
+    _Alty _Alnod;
+    // bucket 0 holds keys equal to _Mylast, bucket i keys whose highest bit
+    // differing from _Mylast is bit i - 1
+    key_type _Mylast;
+    _Nodeptr _Mybucket[_Bits + 1];
+    mutable _Nodeptr _Mymin; // minimum found by top(), or nullptr
+
+};
+
+#endif /* _MONOTONE_HEAP_H_ */
@@ -20,9 +20,47 @@ SOFTWARE.
 #ifndef POOL_ALLOCATOR_H_
 #define POOL_ALLOCATOR_H_
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <utility>
+#include <vector>
+
+/// Snapshot of a pool's occupancy, returned by pool_allocator::stats().
+struct pool_stats
+{
+    std::size_t blocks = 0;          // blocks currently owned by the pool
+    std::size_t live_slots = 0;      // slots handed out and not yet returned
+    std::size_t free_slots = 0;      // slots on the freelist
+    std::size_t bytes_reserved = 0;  // total size of the blocks
+};
+
+/// Default block source for pool_allocator: every block is a separate
+/// ::operator new allocation.
+///
+/// A block source provides allocate(bytes) and deallocate(block, bytes) for
+/// whole blocks. deallocate must be noexcept, since trim() returns blocks
+/// while its freelist is half rebuilt. If releases_on_destroy is true,
+/// destroying the source frees every block it handed out and the pool skips
+/// the per-block deallocation.
+struct heap_block_source
+{
+    static constexpr bool releases_on_destroy = false;
+
+    void* allocate(std::size_t bytes)
+    {
+        return ::operator new(bytes);
+    }
+
+    void deallocate(void* block, std::size_t) noexcept
+    {
+        ::operator delete(block);
+    }
+};
 
 /// Block-based pool allocator for cache-friendly node allocation.
 ///
@@ -30,10 +68,19 @@ SOFTWARE.
 /// heap allocations. Freed slots are recycled via an intrusive freelist.
 /// Designed for use with rp_heap's _Alloc template parameter.
 ///
+/// Blocks are kept until trim() returns the ones with no live slots, either
+/// on request or automatically once the freelist grows past a threshold set
+/// with set_trim_threshold(). Occupancy is computed only when trimming, so
+/// allocate() and deallocate() do no per-block bookkeeping. recycle() frees
+/// every slot at once without touching them: the blocks are set aside and
+/// sliced into slots again as allocations need them.
+///
 /// Template parameters:
 ///   T         - element type
 ///   BlockSize - size of each memory block in bytes (default 4096)
-template <class T, std::size_t BlockSize = 4096>
+///   Source    - where blocks come from (default heap_block_source; see
+///               mmap_arena.h for an mmap-backed arena)
+template <class T, std::size_t BlockSize = 4096, class Source = heap_block_source>
 class pool_allocator
 {
 public:
@@ -46,7 +93,10 @@ public:
     using difference_type = std::ptrdiff_t;
 
     template <class U>
-    struct rebind { using other = pool_allocator<U, BlockSize>; };
+    struct rebind { using other = pool_allocator<U, BlockSize, Source>; };
+
+    static_assert(noexcept(std::declval<Source&>().deallocate(std::declval<void*>(), std::size_t())),
+                  "Source::deallocate must be noexcept");
 
 private:
     // Alignment for each slot: must satisfy both T and pointer alignment
@@ -70,15 +120,39 @@ private:
     static constexpr std::size_t slots_per_block =
         (BlockSize > header_size) ? (BlockSize - header_size) / slot_size : 1;
 
+    // Bytes allocated per block
+    static constexpr std::size_t block_bytes = header_size + slots_per_block * slot_size;
+
+    static char* next_of(char* p)
+    {
+        char* next;
+        std::memcpy(&next, p, sizeof(char*));
+        return next;
+    }
+
     struct PoolState
     {
         char* block_list = nullptr;  // linked list of blocks; first bytes = next ptr
         char* free_list  = nullptr;  // freelist head; each slot stores next ptr
+        char* spare_list = nullptr;  // recycled blocks not yet sliced into slots
+        std::size_t free_count = 0;  // number of slots on the freelist
+        std::size_t block_count = 0; // number of blocks on block_list
+        std::size_t spare_count = 0; // number of blocks on spare_list
+        std::size_t trim_threshold = 0; // free slots that trigger trim(); 0 = off
+        std::size_t trim_trigger = std::numeric_limits<std::size_t>::max();
+        Source source;
 
         void allocate_block()
         {
-            std::size_t actual = header_size + slots_per_block * slot_size;
-            char* block = static_cast<char*>(::operator new(actual));
+            char* block;
+            if (spare_list)
+            {
+                block = spare_list;
+                spare_list = next_of(block);
+                --spare_count;
+            }
+            else
+                block = static_cast<char*>(source.allocate(block_bytes));
             // Link new block to previous head
             std::memcpy(block, &block_list, sizeof(char*));
             block_list = block;
@@ -90,16 +164,124 @@ private:
                 std::memcpy(slot, &free_list, sizeof(char*));
                 free_list = slot;
             }
+            free_count += slots_per_block;
+            ++block_count;
+        }
+
+        // Frees every block whose slots are all on the freelist and returns
+        // the number of bytes released. Occupancy is found by sorting the
+        // blocks by address and binary-searching each free slot's block; the
+        // freelist is then rebuilt in address order from a bitmap of free
+        // slots, so only the first pass chases the list.
+        std::size_t trim()
+        {
+            // recycled blocks hold no live slot by definition
+            std::size_t spare_released = spare_count;
+            release_spares();
+
+            std::vector<char*> blocks;
+            blocks.reserve(block_count);
+            for (char* block = block_list; block; block = next_of(block))
+                blocks.push_back(block);
+            std::sort(blocks.begin(), blocks.end(), std::less<char*>());
+
+            const std::size_t words = (slots_per_block + 63) / 64;
+            std::vector<std::uint64_t> free_bits(blocks.size() * words, 0);
+            std::vector<std::size_t> free_in(blocks.size(), 0);
+            for (char* slot = free_list; slot; slot = next_of(slot))
+            {
+                std::size_t b = std::upper_bound(blocks.begin(), blocks.end(), slot, std::less<char*>())
+                    - blocks.begin() - 1;
+                std::size_t i = (slot - blocks[b] - header_size) / slot_size;
+                free_bits[b * words + i / 64] |= std::uint64_t(1) << (i % 64);
+                free_in[b]++;
+            }
+            std::size_t released = 0;
+            for (std::size_t count : free_in)
+                released += count == slots_per_block;
+
+            if (released)
+            {
+                free_list = nullptr;
+                block_list = nullptr;
+                for (std::size_t b = blocks.size(); b-- > 0; )
+                {
+                    if (free_in[b] == slots_per_block)
+                    {
+                        source.deallocate(blocks[b], block_bytes);
+                        continue;
+                    }
+                    std::memcpy(blocks[b], &block_list, sizeof(char*));
+                    block_list = blocks[b];
+                    char* start = blocks[b] + header_size;
+                    for (std::size_t i = slots_per_block; i-- > 0; )
+                    {
+                        if (free_bits[b * words + i / 64] >> (i % 64) & 1)
+                        {
+                            char* slot = start + i * slot_size;
+                            std::memcpy(slot, &free_list, sizeof(char*));
+                            free_list = slot;
+                        }
+                    }
+                }
+                free_count -= released * slots_per_block;
+                block_count -= released;
+            }
+            rearm();
+            return (released + spare_released) * block_bytes;
+        }
+
+        // Every slot becomes free in O(blocks): the blocks move to the spare
+        // list as they are, and the freelist through them is forgotten.
+        void recycle()
+        {
+            if (block_list)
+            {
+                char* last = block_list;
+                for (char* next = next_of(last); next; next = next_of(last))
+                    last = next;
+                std::memcpy(last, &spare_list, sizeof(char*));
+                spare_list = block_list;
+                spare_count += block_count;
+            }
+            block_list = nullptr;
+            free_list = nullptr;
+            block_count = 0;
+            free_count = 0;
+            rearm();
+        }
+
+        void release_spares()
+        {
+            while (spare_list)
+            {
+                char* next = next_of(spare_list);
+                source.deallocate(spare_list, block_bytes);
+                spare_list = next;
+            }
+            spare_count = 0;
+        }
+
+        // The automatic trigger sits past what the last trim could not
+        // release, so fragmented pools are not rescanned on every free.
+        void rearm()
+        {
+            trim_trigger = trim_threshold
+                ? free_count + std::max(trim_threshold, free_count)
+                : std::numeric_limits<std::size_t>::max();
         }
 
         ~PoolState()
         {
+            if (Source::releases_on_destroy)
+                return;
+            release_spares();
             char* block = block_list;
             while (block)
             {
                 char* next;
                 std::memcpy(&next, block, sizeof(char*));
-                ::operator delete(block);
+                source.deallocate(block, block_bytes);
                 block = next;
             }
         }
@@ -119,7 +301,7 @@ public:
 
     /// Rebind constructor: creates an independent pool for a different type.
     template <class U>
-    pool_allocator(const pool_allocator<U, BlockSize>&)
+    pool_allocator(const pool_allocator<U, BlockSize, Source>&)
         : state_(std::make_shared<PoolState>()) {}
 
     pointer allocate(size_type n)
@@ -130,10 +312,11 @@ public:
             state_->allocate_block();
         char* slot = state_->free_list;
         std::memcpy(&state_->free_list, slot, sizeof(char*));
+        --state_->free_count;
         return reinterpret_cast<pointer>(slot);
     }
 
-    void deallocate(pointer p, size_type n)
+    void deallocate(pointer p, size_type n) noexcept
     {
         if (n != 1)
         {
@@ -143,6 +326,69 @@ public:
         char* slot = reinterpret_cast<char*>(p);
         std::memcpy(slot, &state_->free_list, sizeof(char*));
         state_->free_list = slot;
+        if (++state_->free_count > state_->trim_trigger)
+        {
+            // deallocate() runs from destructors, so a trim that cannot get
+            // its scratch vectors is skipped until the trigger comes round
+            // again; trim() leaves the pool consistent if they throw
+            try
+            {
+                state_->trim();
+            }
+            catch (...)
+            {
+                state_->rearm();
+            }
+        }
+    }
+
+    /// Grows the pool until at least n single-object allocations can be
+    /// served without allocating another block.
+    void reserve(size_type n)
+    {
+        while (state_->free_count < n)
+            state_->allocate_block();
+    }
+
+    /// Marks every slot free in O(blocks), without destroying what is in
+    /// them. Only for a pool whose live objects need no destructor and are
+    /// all being discarded, e.g. by rp_heap::clear(); see sole_owner().
+    void recycle()
+    {
+        state_->recycle();
+    }
+
+    /// True if no copy of this allocator shares its pool, so every live
+    /// slot was allocated through this object.
+    bool sole_owner() const
+    {
+        return state_.use_count() == 1;
+    }
+
+    /// Returns every block with no live slots to the system. Returns the
+    /// number of bytes released.
+    size_type trim()
+    {
+        return state_->trim();
+    }
+
+    /// Makes deallocate() call trim() once more than free_slots slots are
+    /// free (beyond what the previous trim could not release). 0 disables
+    /// automatic trimming, which is the default.
+    void set_trim_threshold(size_type free_slots)
+    {
+        state_->trim_threshold = free_slots;
+        state_->rearm();
+    }
+
+    pool_stats stats() const
+    {
+        pool_stats st;
+        st.blocks = state_->block_count + state_->spare_count;
+        st.free_slots = state_->free_count + state_->spare_count * slots_per_block;
+        st.live_slots = st.blocks * slots_per_block - st.free_slots;
+        st.bytes_reserved = st.blocks * block_bytes;
+        return st;
     }
 
     template <class U, class... Args>
@@ -22,11 +22,26 @@ SOFTWARE.
 
 // #include <assert.h>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <istream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <ostream>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <stack>
+
+#include "rp_heap_core.h"
+
+// tag selecting _Node's in-place constructor
+struct _In_place_tag
+{
+};
 
 template <class _Ty>
 struct _Node
@@ -42,6 +57,12 @@ struct _Node
         _Left = _Next = _Parent = nullptr;
         _Rank = 0;
     }
+    template <class... _Valty>
+    _Node(_In_place_tag, _Valty&&... _Vals) : _Val(std::forward<_Valty>(_Vals)...)
+    {
+        _Left = _Next = _Parent = nullptr;
+        _Rank = 0;
+    }
     _Ty _Val;
     _Nodeptr _Left, _Next, _Parent;
     int _Rank;
@@ -49,6 +70,32 @@ private:
     _Node& operator=(const _Node&);
 };
 
+/// Value codec for rp_heap::save() and load() that copies the bytes of
+/// trivially copyable values. A codec for other types provides the same two
+/// members: write(out, value) and read(in) returning the value.
+template <class _Ty>
+struct rp_heap_raw_codec
+{
+    static_assert(std::is_trivially_copyable<_Ty>::value,
+                  "rp_heap_raw_codec needs trivially copyable values; pass a codec");
+
+    // straight to the stream buffer: one sentry per value would cost more
+    // than the copy
+    void write(std::ostream& _Out, const _Ty& _Val) const
+    {
+        if (_Out.rdbuf()->sputn(reinterpret_cast<const char*>(&_Val), sizeof(_Ty)) != sizeof(_Ty))
+            _Out.setstate(std::ios_base::badbit);
+    }
+
+    _Ty read(std::istream& _In) const
+    {
+        _Ty _Val;
+        if (_In.rdbuf()->sgetn(reinterpret_cast<char*>(&_Val), sizeof(_Ty)) != sizeof(_Ty))
+            _In.setstate(std::ios_base::failbit | std::ios_base::eofbit);
+        return _Val;
+    }
+};
+
 template <class _Myheap>
 class _Iterator
 {
@@ -75,12 +122,13 @@ public:
     _Nodeptr _Ptr;
 };
 
-template <class _Ty, class _Pr = std::less<_Ty>, class _Alloc = std::allocator<_Ty>>
-class rp_heap
+template <class _Ty, class _Pr = std::less<_Ty>, class _Alloc = std::allocator<_Ty>,
+          class _Stats = rp_heap_no_stats, class _Pass = rp_heap_multipass>
+class rp_heap : private _Stats_base<_Stats>
 {
 public:
-    typedef rp_heap<_Ty, _Pr, _Alloc> _Myt;
-    typedef _Node<_Ty> _Node;
+    typedef rp_heap<_Ty, _Pr, _Alloc, _Stats, _Pass> _Myt;
+    typedef ::_Node<_Ty> _Node;
     typedef _Node* _Nodeptr;
 
     typedef _Pr key_compare;
@@ -98,6 +146,8 @@ public:
     typedef typename _Alloc_traits::size_type size_type;
 
     typedef _Iterator<_Myt> const_iterator;
+    typedef _Stats stats_policy;
+    typedef _Pass consolidation_policy;
 
     rp_heap(const _Pr& _Pred = _Pr()) : comp(_Pred)
     {
@@ -105,6 +155,13 @@ public:
         _Myhead = nullptr;
     }
 
+    template <class _InIt,
+              class = typename std::iterator_traits<_InIt>::iterator_category>
+    rp_heap(_InIt _First, _InIt _Last, const _Pr& _Pred = _Pr()) : rp_heap(_Pred)
+    {
+        push_range(_First, _Last);
+    }
+
     rp_heap(const rp_heap&) = delete;
     rp_heap& operator=(const rp_heap&) = delete;
 
@@ -130,50 +187,101 @@ public:
 
     const_iterator push(const value_type& _Val)
     {
-        _Nodeptr _Ptr = _Alty_traits::allocate(_Alnod, 1);
-        _Alty_traits::construct(_Alnod, _Ptr, _Val);
-        _Insert_root(_Ptr);
-        _Mysize++;
-        return const_iterator(_Ptr);
+        return emplace(_Val);
     }
 
     const_iterator push(value_type&& x)
     {
-        _Nodeptr _Ptr = _Alty_traits::allocate(_Alnod, 1);
-        _Alty_traits::construct(_Alnod, _Ptr, std::forward<value_type>(x));
+        return emplace(std::move(x));
+    }
+
+    // construct the element in its node from _Vals, with no temporary
+    template <class... _Valty>
+    const_iterator emplace(_Valty&&... _Vals)
+    {
+        _Nodeptr _Ptr = _Buynode(std::forward<_Valty>(_Vals)...);
         _Insert_root(_Ptr);
         _Mysize++;
         return const_iterator(_Ptr);
     }
 
-    void pop() //delete min
+    // bulk insert: the new nodes are chained into one list and spliced into
+    // the root list with a single comparison against the current min
+    template <class _InIt>
+    void push_range(_InIt _First, _InIt _Last)
     {
-        if (empty())
-            throw std::runtime_error("pop error: empty heap");
-        std::vector<_Nodeptr> _Bucket(_Max_bucket_size(), nullptr);
-        // assert_children(_MinRoot);
-        for (_Nodeptr _Ptr = _Myhead->_Left; _Ptr; )
+        _Push_range(_First, _Last, _Construct_from_value(), [](_Nodeptr) {});
+    }
+
+    // same as above, writing one const_iterator handle per element to _Dest
+    template <class _InIt, class _OutIt>
+    _OutIt push_range(_InIt _First, _InIt _Last, _OutIt _Dest)
+    {
+        _Push_range(_First, _Last, _Construct_from_value(), [&](_Nodeptr _Ptr) { *_Dest++ = const_iterator(_Ptr); });
+        return _Dest;
+    }
+
+    // bulk emplace: each element of [_First, _Last) is a tuple of
+    // constructor arguments, unpacked into a new node; linked like push_range
+    template <class _InIt>
+    void emplace_range(_InIt _First, _InIt _Last)
+    {
+        _Push_range(_First, _Last, _Emplace_from_tuple(), [](_Nodeptr) {});
+    }
+
+    template <class _InIt, class _OutIt>
+    _OutIt emplace_range(_InIt _First, _InIt _Last, _OutIt _Dest)
+    {
+        _Push_range(_First, _Last, _Emplace_from_tuple(), [&](_Nodeptr _Ptr) { *_Dest++ = const_iterator(_Ptr); });
+        return _Dest;
+    }
+
+    // move all elements of _Right into this heap and leave _Right empty.
+    // with equal allocators the two root lists are spliced in O(1) and every
+    // handle into _Right stays valid (now referring into this heap);
+    // otherwise the values are moved into new nodes in O(n) and handles into
+    // _Right are invalidated
+    void meld(rp_heap& _Right)
+    {
+        if (this == &_Right || _Right.empty())
+            return;
+        if (_Alnod == _Right._Alnod)
         {
-            _Nodeptr _NextPtr = _Ptr->_Next;
-            _Ptr->_Next = nullptr;
-            _Ptr->_Parent = nullptr;
-            _Multipass(_Bucket, _Ptr);
-            _Ptr = _NextPtr;
+            if (_Myhead == nullptr)
+                _Myhead = _Right._Myhead;
+            else
+            {
+                std::swap(_Myhead->_Next, _Right._Myhead->_Next);
+                if (_Compare(_Right._Myhead->_Val, _Myhead->_Val))
+                    _Myhead = _Right._Myhead;
+            }
+            _Mysize += _Right._Mysize;
+            _Right._Myhead = nullptr;
+            _Right._Mysize = 0;
         }
-        for (_Nodeptr _Ptr = _Myhead->_Next; _Ptr != _Myhead; )
+        else
         {
-            _Nodeptr _NextPtr = _Ptr->_Next;
-            _Ptr->_Next = nullptr;
-            _Multipass(_Bucket, _Ptr);
-            _Ptr = _NextPtr;
+            reserve(_Mysize + _Right._Mysize);
+            std::vector<_Nodeptr> _Stack(1, _Right._Myhead);
+            while (!_Stack.empty())
+            {
+                _Nodeptr _Ptr = _Stack.back();
+                _Stack.pop_back();
+                if (_Ptr->_Left)
+                    _Stack.push_back(_Ptr->_Left);
+                if (_Ptr->_Next && _Ptr->_Next != _Right._Myhead)
+                    _Stack.push_back(_Ptr->_Next);
+                push(std::move(_Ptr->_Val));
+            }
+            _Right.clear();
         }
-        _Freenode(_Myhead);
-        _Myhead = nullptr;
-        std::for_each(_Bucket.begin(), _Bucket.end(), [&](_Nodeptr _Ptr)
-        {
-            if (_Ptr)
-                _Insert_root(_Ptr);
-        });
+    }
+
+    void pop() //delete min
+    {
+        if (empty())
+            throw std::runtime_error("pop error: empty heap");
+        _Freenode(_Unlink_head());
     }
 
     void pop(value_type& _Val)
@@ -184,92 +292,471 @@ public:
         pop();
     }
 
+    // extract the min(_Count, size()) smallest elements in ascending order,
+    // moving them to _Dest, with one consolidation for the whole batch
+    // instead of one per element: the best-first walk of peek_k() finds
+    // them, they are detached together, and what is left of the frontier
+    // (untouched roots and the orphaned subtrees of extracted nodes) is
+    // linked by rank once
+    template <class _OutIt>
+    _OutIt pop_n(size_type _Count, _OutIt _Dest)
+    {
+        if (_Count > _Mysize)
+            _Count = _Mysize;
+        if (_Count == 0)
+            return _Dest;
+        // the walk has read a node's _Next (root list or right sibling) by
+        // the time it visits it, so the taken nodes chain through _Next
+        _Nodeptr _Taken = nullptr, _Taken_last = nullptr;
+        std::vector<_Nodeptr> _Frontier = _Smallest(_Count, [&](_Nodeptr _Ptr) {
+            _Ptr->_Next = nullptr;
+            if (_Taken_last)
+                _Taken_last->_Next = _Ptr;
+            else
+                _Taken = _Ptr;
+            _Taken_last = _Ptr;
+        });
+        // every node left in the frontier heads a half tree of its own
+        _Nodeptr _Done = nullptr;
+        _Myhead = nullptr;
+        _Algo::_Prepare_bucket(_Nodes(), _Mybucket, _Mysize);
+        int _Top = -1;
+        for (_Nodeptr _Ptr : _Frontier)
+            _Algo::_Consolidate_child(_Nodes(), _Mybucket, _Ptr, _Done, _Top);
+        this->_Get_stats().on_consolidate(_Frontier.size());
+        _Algo::_Restore_roots(_Nodes(), _Myhead, _Mybucket, _Done, _Top);
+        // the heap no longer reaches the taken nodes: free each once its
+        // value is out, and the rest if writing one throws
+        try
+        {
+            for (; _Taken; _Taken = _Free_and_next(_Taken))
+                *_Dest++ = std::move(_Taken->_Val);
+        }
+        catch (...)
+        {
+            while (_Taken)
+                _Taken = _Free_and_next(_Taken);
+            throw;
+        }
+        return _Dest;
+    }
+
+    // copy the min(_Count, size()) smallest elements in ascending order to
+    // _Dest without modifying the heap: a best-first walk over the half
+    // trees, where emitting a node makes its children (its left child and
+    // that child's right spine) candidates
+    template <class _OutIt>
+    _OutIt peek_k(size_type _Count, _OutIt _Dest) const
+    {
+        if (_Count > _Mysize)
+            _Count = _Mysize;
+        if (_Count == 0)
+            return _Dest;
+        _Smallest(_Count, [&](_Nodeptr _Ptr) { *_Dest++ = _Ptr->_Val; });
+        return _Dest;
+    }
+
+    // pre-size the rank bucket workspace (one bucket per rank a heap of
+    // _Count elements can reach) and, when the node allocator supports it
+    // (e.g. pool_allocator), its free slots for _Count elements, so that
+    // push/pop up to that size never call the global allocator
+    void reserve(size_type _Count)
+    {
+        size_type _Bound = _Rp_bucket_size_for(_Count);
+        if (_Mybucket.size() < _Bound)
+            _Mybucket.resize(_Bound, nullptr);
+        if (_Count > _Mysize)
+            _Reserve_nodes(_Alnod, _Count - _Mysize, 0);
+    }
+
+    // release the part of the bucket workspace not needed at the current
+    // size, and unused node memory if the allocator has a trim() member
+    void shrink_to_fit()
+    {
+        if (empty())
+            std::vector<_Nodeptr>().swap(_Mybucket);
+        else
+        {
+            size_type _Bound = _Rp_bucket_size_for(_Mysize);
+            if (_Mybucket.size() > _Bound)
+                _Mybucket.resize(_Bound);
+            _Mybucket.shrink_to_fit();
+        }
+        _Trim_nodes(_Alnod, 0);
+    }
+
+    // destroy every element. When nodes need no destructor and the heap is
+    // the only user of a pool allocator with recycle(), the whole pool is
+    // marked free in O(blocks); otherwise the nodes are freed one by one in
+    // a walk that allocates nothing
     void clear()
     {
-        // while (!empty())
-        //     pop();
-        // post order traversal using two stacks
         if (!empty())
         {
-            std::stack<_Nodeptr> _Stack_in, _Stack_out;
-            _Stack_in.push(_Myhead);
-            while (!_Stack_in.empty())
-            {
-                _Nodeptr _Ptr = _Stack_in.top();
-                _Stack_in.pop();
-                _Stack_out.push(_Ptr);
-                if (_Ptr->_Left)
-                    _Stack_in.push(_Ptr->_Left);
-                if (_Ptr->_Next && _Ptr->_Next != _Myhead)
-                    _Stack_in.push(_Ptr->_Next);
-            }
-            while (!_Stack_out.empty())
-            {
-                _Nodeptr _Ptr = _Stack_out.top();
-                _Freenode(_Ptr);
-                _Stack_out.pop();
-            }
+            if (!_Recycle_nodes(_Alnod, 0))
+                _Free_all();
+            _Mysize = 0;
         }
         _Myhead = nullptr;
-        //assert(empty());
     }
 
     void decrease(const_iterator _It, const value_type& _Val)
     {
         _Nodeptr _Ptr = _It._Ptr;
-        if (comp(_Val, _Ptr->_Val))
+        if (_Compare(_Val, _Ptr->_Val))
             _Ptr->_Val = _Val;
         if (_Ptr == _Myhead)
             return;
         if (_Ptr->_Parent == nullptr) //one of the roots
         {
-            if (comp(_Ptr->_Val, _Myhead->_Val))
+            if (_Compare(_Ptr->_Val, _Myhead->_Val))
                 _Myhead = _Ptr;
         }
         else
         {
-            _Nodeptr _ParentPtr = _Ptr->_Parent;
-            if (_Ptr == _ParentPtr->_Left)
-            {
-                _ParentPtr->_Left = _Ptr->_Next;
-                if (_ParentPtr->_Left)
-                    _ParentPtr->_Left->_Parent = _ParentPtr;
-            }
-            else
+            _Algo::_Cut(_Nodes(), _Ptr);
+            _Insert_root(_Ptr);
+        }
+    }
+
+    // change the value in either direction: a smaller value is a decrease,
+    // a larger one detaches the node, spreads its children over the root
+    // list and reinserts it as a singleton root
+    void update(const_iterator _It, const value_type& _Val)
+    {
+        _Nodeptr _Ptr = _It._Ptr;
+        if (_Compare(_Val, _Ptr->_Val))
+            decrease(_It, _Val);
+        else if (_Compare(_Ptr->_Val, _Val))
+        {
+            _Unlink(_Ptr);
+            _Ptr->_Val = _Val;
+            _Insert_root(_Ptr);
+        }
+        else
+            _Ptr->_Val = _Val;
+    }
+
+    // remove an arbitrary element; erasing a root (including the min) costs
+    // the same as pop(), any other node is cut in O(1) amortized and its
+    // children become roots
+    void erase(const_iterator _It)
+    {
+        _Nodeptr _Ptr = _It._Ptr;
+        _Unlink(_Ptr);
+        _Freenode(_Ptr);
+    }
+
+    // operation counters collected by the _Stats policy (all zero with the
+    // default rp_heap_no_stats)
+    rp_heap_stats stats() const
+    {
+        return this->_Get_stats().snapshot();
+    }
+
+    void reset_stats()
+    {
+        this->_Get_stats().reset();
+    }
+
+    // write a snapshot of the heap: a header, then every half tree in
+    // root-list order starting at the min, each in pre-order (node, left
+    // subtree, right subtree). A node is one tag byte (has-left and
+    // has-right bits, rank below 63 or an escape to a second rank byte)
+    // followed by its value through _Io. Multi-byte fields are in host byte
+    // order. The stream's state reports write errors.
+    void save(std::ostream& _Out) const
+    {
+        save(_Out, rp_heap_raw_codec<value_type>());
+    }
+
+    template <class _Codec>
+    void save(std::ostream& _Out, _Codec _Io) const
+    {
+        _Write_header(_Out, _Mysize, _Myhead ? _Count_roots() : 0);
+        if (_Myhead == nullptr)
+            return;
+        std::vector<_Nodeptr> _Stack;
+        _Nodeptr _Root = _Myhead;
+        do
+        {
+            _Stack.push_back(_Root);
+            while (!_Stack.empty())
             {
-                _ParentPtr->_Next = _Ptr->_Next;
-                if (_ParentPtr->_Next)
-                    _ParentPtr->_Next->_Parent = _ParentPtr;
+                _Nodeptr _Ptr = _Stack.back();
+                _Stack.pop_back();
+                // a root's _Next is the root list, not a subtree
+                _Nodeptr _Right = _Ptr->_Parent ? _Ptr->_Next : nullptr;
+                _Write_tag(_Out, _Ptr->_Left != nullptr, _Right != nullptr, _Ptr->_Rank);
+                _Io.write(_Out, _Ptr->_Val);
+                if (_Right)
+                    _Stack.push_back(_Right);
+                if (_Ptr->_Left)
+                    _Stack.push_back(_Ptr->_Left);
             }
-            // assert_children(_ParentPtr);
-            _Ptr->_Next = _Ptr->_Parent = nullptr;
-            _Ptr->_Rank = (_Ptr->_Left) ? _Ptr->_Left->_Rank + 1 : 0;
-            // assert_half_tree(_Ptr);
-            _Insert_root(_Ptr);
-            //type-2 rank reduction
-            if (_ParentPtr->_Parent == nullptr) // is a root
-                _ParentPtr->_Rank = (_ParentPtr->_Left) ? _ParentPtr->_Left->_Rank + 1 : 0;
-            else
+            _Root = _Root->_Next;
+        } while (_Root != _Myhead);
+    }
+
+    // replace the contents with a snapshot written by save(), rebuilding the
+    // exact shape (links, ranks, root order) in one pass and without a
+    // single comparison. Throws std::runtime_error if the stream is not a
+    // snapshot or ends early, leaving the heap empty.
+    void load(std::istream& _In)
+    {
+        rp_heap_raw_codec<value_type> _Io;
+        _Load(_In, _Io, [](_Nodeptr) {});
+    }
+
+    template <class _Codec>
+    void load(std::istream& _In, _Codec _Io)
+    {
+        _Load(_In, _Io, [](_Nodeptr) {});
+    }
+
+    // same as above, writing one const_iterator per element to _Dest in
+    // snapshot order, which is the order save() visited them in
+    template <class _Codec, class _OutIt>
+    _OutIt load(std::istream& _In, _Codec _Io, _OutIt _Dest)
+    {
+        _Load(_In, _Io, [&](_Nodeptr _Ptr) { *_Dest++ = const_iterator(_Ptr); });
+        return _Dest;
+    }
+
+private:
+    static constexpr std::uint32_t _Snapshot_magic = 0x50485052; // "RPHP" in little-endian
+    static constexpr std::uint32_t _Snapshot_version = 1;
+    static constexpr unsigned char _Tag_left = 0x80;
+    static constexpr unsigned char _Tag_right = 0x40;
+    static constexpr unsigned char _Tag_rank = 0x3f; // 63 escapes to a rank byte
+
+    size_type _Count_roots() const
+    {
+        size_type _Roots = 1;
+        for (_Nodeptr _Ptr = _Myhead->_Next; _Ptr != _Myhead; _Ptr = _Ptr->_Next)
+            _Roots++;
+        return _Roots;
+    }
+
+    static void _Write_header(std::ostream& _Out, std::uint64_t _Size, std::uint64_t _Roots)
+    {
+        const std::uint32_t _Head[2] = {_Snapshot_magic, _Snapshot_version};
+        _Out.write(reinterpret_cast<const char*>(_Head), sizeof(_Head));
+        _Out.write(reinterpret_cast<const char*>(&_Size), sizeof(_Size));
+        _Out.write(reinterpret_cast<const char*>(&_Roots), sizeof(_Roots));
+    }
+
+    static void _Write_tag(std::ostream& _Out, bool _Has_left, bool _Has_right, int _Rank)
+    {
+        unsigned char _Tag[2];
+        _Tag[0] = static_cast<unsigned char>((_Has_left ? _Tag_left : 0) | (_Has_right ? _Tag_right : 0));
+        std::streamsize _Count = 1;
+        if (_Rank < _Tag_rank)
+            _Tag[0] |= static_cast<unsigned char>(_Rank);
+        else
+        {
+            _Tag[0] |= _Tag_rank;
+            _Tag[1] = static_cast<unsigned char>(_Rank);
+            _Count = 2;
+        }
+        if (_Out.rdbuf()->sputn(reinterpret_cast<const char*>(_Tag), _Count) != _Count)
+            _Out.setstate(std::ios_base::badbit);
+    }
+
+    template <class _Codec, class _Fn>
+    void _Load(std::istream& _In, _Codec& _Io, _Fn _On_node)
+    {
+        clear();
+        std::uint32_t _Head[2];
+        std::uint64_t _Size, _Roots;
+        _In.read(reinterpret_cast<char*>(_Head), sizeof(_Head));
+        _In.read(reinterpret_cast<char*>(&_Size), sizeof(_Size));
+        _In.read(reinterpret_cast<char*>(&_Roots), sizeof(_Roots));
+        if (!_In || _Head[0] != _Snapshot_magic)
+            throw std::runtime_error("load error: not an rp_heap snapshot");
+        if (_Head[1] != _Snapshot_version)
+            throw std::runtime_error("load error: unsupported snapshot version");
+        if ((_Size == 0) != (_Roots == 0) || _Roots > _Size)
+            throw std::runtime_error("load error: corrupt snapshot header");
+        // every node takes at least its tag byte, so the header's size is
+        // only trusted as far as the stream is known to hold that many
+        // bytes; a corrupt size cannot force a huge reservation
+        bool _Exact;
+        std::uint64_t _Avail = _Readable_bytes(_In, _Exact);
+        if (_Exact && _Size > _Avail)
+        {
+            _In.setstate(std::ios_base::failbit | std::ios_base::eofbit);
+            throw std::runtime_error("load error: snapshot ends early");
+        }
+        try
+        {
+            reserve(static_cast<size_type>(std::min<std::uint64_t>(_Size, std::max<std::uint64_t>(_Avail, 4096))));
+            // each slot is a link still to be filled by the next node read,
+            // with the node it belongs to; a null link is a new root
+            std::vector<std::pair<_Nodeptr*, _Nodeptr>> _Slots;
+            _Nodeptr _Last_root = nullptr;
+            for (std::uint64_t _Root = 0; _Root < _Roots; ++_Root)
             {
-                while (_ParentPtr->_Parent)
+                _Slots.emplace_back(nullptr, nullptr);
+                while (!_Slots.empty())
                 {
-                    int i = _ParentPtr->_Left ? _ParentPtr->_Left->_Rank : -1;
-                    int j = _ParentPtr->_Next ? _ParentPtr->_Next->_Rank : -1;
-#ifdef TYPE1_RANK_REDUCTION
-                    int k = (i != j) ? std::max(i, j) : i + 1; //type-1 rank reduction
-#else
-                    int k = (abs(i - j) > 1) ? std::max(i, j) : std::max(i, j) + 1; //type-2 rank reduction
-#endif // TYPE1_RANK_REDUCTION
-                    if (k >= _ParentPtr->_Rank)
-                        break;
-                    _ParentPtr->_Rank = k;
-                    _ParentPtr = _ParentPtr->_Parent;
+                    std::pair<_Nodeptr*, _Nodeptr> _Slot = _Slots.back();
+                    _Slots.pop_back();
+                    if (_Mysize == _Size)
+                        throw std::runtime_error("load error: more nodes than the header says");
+                    unsigned char _Tag = _Read_byte(_In);
+                    int _Rank = _Tag & _Tag_rank;
+                    if (_Rank == _Tag_rank)
+                        _Rank = _Read_byte(_In);
+                    _Nodeptr _Ptr = _Buynode(_Io.read(_In));
+                    _Mysize++;
+                    _Ptr->_Rank = _Rank;
+                    if (_Slot.first)
+                    {
+                        *_Slot.first = _Ptr;
+                        _Ptr->_Parent = _Slot.second;
+                    }
+                    else if (_Last_root == nullptr)
+                    {
+                        // the first root is the min
+                        _Myhead = _Last_root = _Ptr;
+                        _Ptr->_Next = _Ptr;
+                    }
+                    else
+                    {
+                        _Ptr->_Next = _Myhead;
+                        _Last_root->_Next = _Ptr;
+                        _Last_root = _Ptr;
+                    }
+                    _On_node(_Ptr);
+                    if (!_In)
+                        throw std::runtime_error("load error: snapshot ends early");
+                    if ((_Tag & _Tag_right) && !_Slot.first)
+                        throw std::runtime_error("load error: root with a right subtree");
+                    // left subtree first: it comes first in pre-order
+                    if (_Tag & _Tag_right)
+                        _Slots.emplace_back(&_Ptr->_Next, _Ptr);
+                    if (_Tag & _Tag_left)
+                        _Slots.emplace_back(&_Ptr->_Left, _Ptr);
                 }
             }
+            if (_Mysize != _Size)
+                throw std::runtime_error("load error: fewer nodes than the header says");
+        }
+        catch (...)
+        {
+            // every node read so far hangs off the root list through links
+            // that are either set or still null, so clear() frees them all
+            clear();
+            throw;
         }
     }
 
-private:
+    // the bytes left in _In: exact (_Exact) when its buffer can seek,
+    // otherwise the lower bound in_avail() gives
+    static std::uint64_t _Readable_bytes(std::istream& _In, bool& _Exact)
+    {
+        std::streambuf* _Buf = _In.rdbuf();
+        const std::streampos _Bad(std::streamoff(-1));
+        std::streampos _Here = _Buf->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+        std::streampos _End = _Bad;
+        if (_Here != _Bad)
+        {
+            _End = _Buf->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+            _Buf->pubseekpos(_Here, std::ios_base::in);
+        }
+        _Exact = _Here != _Bad && _End != _Bad && _End >= _Here;
+        if (_Exact)
+            return static_cast<std::uint64_t>(_End - _Here);
+        std::streamsize _Count = _Buf->in_avail();
+        return _Count > 0 ? static_cast<std::uint64_t>(_Count) : 0;
+    }
+
+    static unsigned char _Read_byte(std::istream& _In)
+    {
+        typedef std::istream::traits_type _Traits;
+        _Traits::int_type _Byte = _In.rdbuf()->sbumpc();
+        if (_Traits::eq_int_type(_Byte, _Traits::eof()))
+        {
+            _In.setstate(std::ios_base::failbit | std::ios_base::eofbit);
+            throw std::runtime_error("load error: snapshot ends early");
+        }
+        return static_cast<unsigned char>(_Traits::to_char_type(_Byte));
+    }
+
+    bool _Compare(const value_type& _Left, const value_type& _Right) const
+    {
+        this->_Get_stats().on_compare();
+        return comp(_Left, _Right);
+    }
+
+    // visit the _Count (> 0, <= size()) smallest nodes in ascending order: a
+    // best-first walk over the half trees, where visiting a node makes its
+    // children (its left child and that child's right spine) candidates.
+    // Returns the candidates never visited, in no particular order
+    template <class _Fn>
+    std::vector<_Nodeptr> _Smallest(size_type _Count, _Fn _Visit) const
+    {
+        auto _Greater = [this](_Nodeptr _Left, _Nodeptr _Right) { return _Compare(_Right->_Val, _Left->_Val); };
+        std::vector<_Nodeptr> _Frontier;
+        _Frontier.push_back(_Myhead);
+        for (_Nodeptr _Ptr = _Myhead->_Next; _Ptr != _Myhead; _Ptr = _Ptr->_Next)
+            _Frontier.push_back(_Ptr);
+        std::make_heap(_Frontier.begin(), _Frontier.end(), _Greater);
+        for (; _Count > 0; --_Count)
+        {
+            std::pop_heap(_Frontier.begin(), _Frontier.end(), _Greater);
+            _Nodeptr _Ptr = _Frontier.back();
+            _Frontier.pop_back();
+            for (_Nodeptr _Child = _Ptr->_Left; _Child; _Child = _Child->_Next)
+            {
+                _Frontier.push_back(_Child);
+                std::push_heap(_Frontier.begin(), _Frontier.end(), _Greater);
+            }
+            _Visit(_Ptr);
+        }
+        return _Frontier;
+    }
+
+    // the node access the shared core runs on
+    struct _Node_access
+    {
+        typedef typename rp_heap::_Nodeptr _Nodeptr;
+        const rp_heap* _Heap;
+
+        _Nodeptr nil() const { return nullptr; }
+        _Nodeptr& left(_Nodeptr _Ptr) const { return _Ptr->_Left; }
+        _Nodeptr& next(_Nodeptr _Ptr) const { return _Ptr->_Next; }
+        _Nodeptr& parent(_Nodeptr _Ptr) const { return _Ptr->_Parent; }
+        int& rank(_Nodeptr _Ptr) const { return _Ptr->_Rank; }
+        bool less(_Nodeptr _Left, _Nodeptr _Right) const { return _Heap->comp(_Left->_Val, _Right->_Val); }
+        _Stats& stats() const { return _Heap->_Get_stats(); }
+    };
+    typedef _Rp_algo<_Node_access, _Pass> _Algo;
+
+    _Node_access _Nodes() const
+    {
+        return _Node_access{this};
+    }
+
+    // consolidate the root list and the children of the min, and return the
+    // old min detached from the heap (still counted in _Mysize)
+    _Nodeptr _Unlink_head()
+    {
+        return _Algo::_Unlink_head(_Nodes(), _Myhead, _Mybucket, _Mysize);
+    }
+
+    // detach _Ptr from the heap, leaving it a childless singleton that is
+    // still counted in _Mysize
+    void _Unlink(_Nodeptr _Ptr)
+    {
+        _Algo::_Unlink(_Nodes(), _Myhead, _Mybucket, _Mysize, _Ptr);
+    }
+
+    void _Insert_root(_Nodeptr _Ptr)
+    {
+        _Algo::_Insert_root(_Nodes(), _Myhead, _Ptr);
+    }
 
     void _Freenode(_Nodeptr _Ptr)
     {
@@ -278,6 +765,13 @@ private:
         _Mysize--;
     }
 
+    _Nodeptr _Free_and_next(_Nodeptr _Ptr)
+    {
+        _Nodeptr _NextPtr = _Ptr->_Next;
+        _Freenode(_Ptr);
+        return _NextPtr;
+    }
+
     // void assert_half_tree(_Nodeptr _Ptr)
     // {
     //     assert(_Ptr->_Next == nullptr && _Ptr->_Parent == nullptr);
@@ -296,91 +790,191 @@ private:
     //         assert(_Ptr->_Next->_Parent == _Ptr);
     // }
 
-    void _Insert_root(_Nodeptr _Ptr)
+    // allocate a node and construct its element from _Vals, releasing the
+    // memory if the constructor throws
+    template <class... _Valty>
+    _Nodeptr _Buynode(_Valty&&... _Vals)
     {
-        if (_Myhead == nullptr)
+        _Nodeptr _Ptr = _Alty_traits::allocate(_Alnod, 1);
+        try
         {
-            _Myhead = _Ptr;
-            _Ptr->_Next = _Ptr;
+            _Alty_traits::construct(_Alnod, _Ptr, _In_place_tag(), std::forward<_Valty>(_Vals)...);
         }
-        else
+        catch (...)
         {
-            _Ptr->_Next = _Myhead->_Next;
-            _Myhead->_Next = _Ptr;
-            if (comp(_Ptr->_Val, _Myhead->_Val))
-                _Myhead = _Ptr;
+            _Alty_traits::deallocate(_Alnod, _Ptr, 1);
+            throw;
         }
+        return _Ptr;
     }
 
-    _Nodeptr _Link(_Nodeptr _Left, _Nodeptr _Right)
+    // how _Push_range builds a node from *_First: push_range converts the
+    // element, emplace_range unpacks a tuple of constructor arguments
+    struct _Construct_from_value
     {
-        if (_Right == nullptr)
-            return _Left;
-        // assert_half_tree(_Left);
-        // assert_half_tree(_Right);
-        _Nodeptr _Winner, _Loser;
-        if (comp(_Right->_Val, _Left->_Val))
+        template <class _Ref>
+        void operator()(_Alty& _Al, _Nodeptr _Ptr, _Ref&& _Arg) const
         {
-            _Winner = _Right;
-            _Loser = _Left;
+            _Alty_traits::construct(_Al, _Ptr, std::forward<_Ref>(_Arg));
         }
-        else
+    };
+
+    struct _Emplace_from_tuple
+    {
+        template <class _Tuple>
+        void operator()(_Alty& _Al, _Nodeptr _Ptr, _Tuple&& _Args) const
+        {
+            _Unpack(_Al, _Ptr, std::forward<_Tuple>(_Args),
+                    std::make_index_sequence<std::tuple_size<typename std::decay<_Tuple>::type>::value>());
+        }
+
+        template <class _Tuple, std::size_t... _Idx>
+        static void _Unpack(_Alty& _Al, _Nodeptr _Ptr, _Tuple&& _Args, std::index_sequence<_Idx...>)
+        {
+            _Alty_traits::construct(_Al, _Ptr, _In_place_tag(), std::get<_Idx>(std::forward<_Tuple>(_Args))...);
+        }
+    };
+
+    template <class _InIt, class _Build, class _Fn>
+    void _Push_range(_InIt _First, _InIt _Last, _Build _Construct, _Fn _On_node)
+    {
+        _Reserve_range(_First, _Last, typename std::iterator_traits<_InIt>::iterator_category());
+        _Nodeptr _Chain_first = nullptr, _Chain_last = nullptr, _Chain_min = nullptr;
+        try
+        {
+            for (; _First != _Last; ++_First)
+            {
+                _Nodeptr _Ptr = _Alty_traits::allocate(_Alnod, 1);
+                try
+                {
+                    _Construct(_Alnod, _Ptr, *_First);
+                }
+                catch (...)
+                {
+                    _Alty_traits::deallocate(_Alnod, _Ptr, 1);
+                    throw;
+                }
+                _Mysize++;
+                if (_Chain_last)
+                    _Chain_last->_Next = _Ptr;
+                else
+                    _Chain_first = _Ptr;
+                _Chain_last = _Ptr;
+                if (_Chain_min == nullptr || _Compare(_Ptr->_Val, _Chain_min->_Val))
+                    _Chain_min = _Ptr;
+                _On_node(_Ptr);
+            }
+        }
+        catch (...)
+        {
+            _Splice_roots(_Chain_first, _Chain_last, _Chain_min);
+            throw;
+        }
+        _Splice_roots(_Chain_first, _Chain_last, _Chain_min);
+    }
+
+    template <class _InIt>
+    void _Reserve_range(_InIt _First, _InIt _Last, std::forward_iterator_tag)
+    {
+        reserve(_Mysize + static_cast<size_type>(std::distance(_First, _Last)));
+    }
+
+    template <class _InIt>
+    void _Reserve_range(_InIt, _InIt, std::input_iterator_tag)
+    {
+    }
+
+    // splice the chain _First .. _Last (linked through _Next) into the root list
+    void _Splice_roots(_Nodeptr _First, _Nodeptr _Last, _Nodeptr _Min)
+    {
+        if (_First == nullptr)
+            return;
+        if (_Myhead == nullptr)
         {
-            _Winner = _Left;
-            _Loser = _Right;
+            _Last->_Next = _First;
+            _Myhead = _Min;
         }
-        _Loser->_Parent = _Winner;
-        if (_Winner->_Left)
+        else
         {
-            _Loser->_Next = _Winner->_Left;
-            _Loser->_Next->_Parent = _Loser;
+            _Last->_Next = _Myhead->_Next;
+            _Myhead->_Next = _First;
+            if (_Compare(_Min->_Val, _Myhead->_Val))
+                _Myhead = _Min;
         }
-        _Winner->_Left = _Loser;
-        _Winner->_Rank = _Loser->_Rank + 1;
-        // assert_children(_Winner);
-        // assert_parent(_Loser);
-        // assert_half_tree(_Winner);
-        return _Winner;
     }
 
-    inline size_type _Max_bucket_size() //ceil(log2(size)) + 1
+    template <class _Al>
+    static auto _Reserve_nodes(_Al& _Al_ref, size_type _Count, int)
+        -> decltype(_Al_ref.reserve(_Count), void())
+    {
+        _Al_ref.reserve(_Count);
+    }
+
+    template <class _Al>
+    static void _Reserve_nodes(_Al&, size_type, long)
+    {
+    }
+
+    template <class _Al>
+    static auto _Trim_nodes(_Al& _Al_ref, int)
+        -> decltype(_Al_ref.trim(), void())
+    {
+        _Al_ref.trim();
+    }
+
+    template <class _Al>
+    static void _Trim_nodes(_Al&, long)
+    {
+    }
+
+    template <class _Al>
+    static auto _Recycle_nodes(_Al& _Al_ref, int)
+        -> decltype(_Al_ref.recycle(), _Al_ref.sole_owner())
+    {
+        if (!std::is_trivially_destructible<_Node>::value || !_Al_ref.sole_owner())
+            return false;
+        _Al_ref.recycle();
+        return true;
+    }
+
+    template <class _Al>
+    static bool _Recycle_nodes(_Al&, long)
     {
-        size_type _Bit = 1, _Count = _Mysize;
-        while (_Count >>= 1)
-            _Bit++;
-        return _Bit + 1;
+        return false;
     }
 
-    template <class _Container>
-    void _Multipass(_Container& _Bucket, _Nodeptr _Ptr)
+    // free every node without a stack: open the root list into a chain
+    // through _Next, then rotate each left child up into the chain (the
+    // child's right spine becomes the parent's left) until the front node
+    // has no left child, and free it. Each rotation moves one node onto the
+    // chain for good, so the walk is O(n)
+    void _Free_all()
     {
-        // if ((size_t)_Ptr->_Rank >= _Bucket.size())
-        // {
-        //     _Bucket.resize(_Ptr->_Rank + 1, nullptr);
-        // }
-        // else
-        // {
-        while (_Bucket[_Ptr->_Rank] != nullptr)
+        _Nodeptr _Ptr = _Myhead->_Next;
+        _Myhead->_Next = nullptr;
+        while (_Ptr)
         {
-            unsigned int _Rank = _Ptr->_Rank;
-            _Ptr = _Link(_Ptr, _Bucket[_Rank]);
-            // assert_children(_Ptr);
-            // assert_half_tree(_Ptr);
-            _Bucket[_Rank] = nullptr;
-            // if ((size_t)_Ptr->_Rank >= _Bucket.size())
-            // {
-            //     _Bucket.resize(_Ptr->_Rank + 1, nullptr);
-            //     break;
-            // }
+            _Nodeptr _Child = _Ptr->_Left;
+            if (_Child)
+            {
+                _Ptr->_Left = _Child->_Next;
+                _Child->_Next = _Ptr;
+                _Ptr = _Child;
+            }
+            else
+            {
+                _Nodeptr _NextPtr = _Ptr->_Next;
+                _Freenode(_Ptr);
+                _Ptr = _NextPtr;
+            }
         }
-        // }
-        _Bucket[_Ptr->_Rank] = _Ptr;
     }
 
     _Pr comp;
     _Nodeptr _Myhead;
     size_type _Mysize;
     _Alty _Alnod;
+    std::vector<_Nodeptr> _Mybucket; // rank buckets reused by every pop
 };
 
 #endif /* _RP_HEAP_H_ */
@@ -0,0 +1,476 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _RP_HEAP_CORE_H_
+#define _RP_HEAP_CORE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// The parts of the rank-pairing heap that do not depend on how a node is
+// stored: the statistics and consolidation policies, and linking, cutting
+// with rank reduction and consolidating half trees. rp_heap (pointer
+// nodes), intrusive_rp_heap (hooks in the caller's objects) and
+// compact_rp_heap (32-bit slab indices) all run this code.
+
+/// Operation counts of an rp_heap, returned by rp_heap::stats(). All zero
+/// unless the heap uses rp_heap_counting_stats.
+struct rp_heap_stats
+{
+    unsigned long long comparisons = 0;          // calls to the comparator
+    unsigned long long links = 0;                // half trees linked by rank
+    unsigned long long consolidations = 0;       // pops, and erases of a root
+    unsigned long long roots_scanned = 0;        // root-list length summed over consolidations
+    unsigned long long max_roots = 0;            // longest root list seen at a consolidation
+    unsigned long long rank_reduction_steps = 0; // ancestors visited after a cut
+    int max_rank = 0;                            // highest rank produced by a link
+};
+
+/// Statistics policy for rp_heap's _Stats parameter that counts nothing.
+/// Every hook is empty and inlines away, so the default heap pays nothing.
+struct rp_heap_no_stats
+{
+    void on_compare() {}
+    void on_link(int) {}
+    void on_consolidate(std::size_t) {}
+    void on_rank_reduction_step() {}
+    rp_heap_stats snapshot() const { return rp_heap_stats(); }
+    void reset() {}
+};
+
+/// Statistics policy that fills in every rp_heap_stats counter.
+struct rp_heap_counting_stats
+{
+    void on_compare() { _Data.comparisons++; }
+    void on_link(int _Rank)
+    {
+        _Data.links++;
+        _Data.max_rank = std::max(_Data.max_rank, _Rank);
+    }
+    void on_consolidate(std::size_t _Roots)
+    {
+        _Data.consolidations++;
+        _Data.roots_scanned += _Roots;
+        _Data.max_roots = std::max<unsigned long long>(_Data.max_roots, _Roots);
+    }
+    void on_rank_reduction_step() { _Data.rank_reduction_steps++; }
+    rp_heap_stats snapshot() const { return _Data; }
+    void reset() { _Data = rp_heap_stats(); }
+
+    rp_heap_stats _Data;
+};
+
+// Holds a heap's _Stats policy. An empty policy such as rp_heap_no_stats
+// is a base class, so the empty base optimization gives it no storage at
+// all; a policy with counters is a mutable member, since const members
+// such as peek_k() compare too.
+template <class _Stats, bool = std::is_empty<_Stats>::value && !std::is_final<_Stats>::value>
+class _Stats_base : private _Stats
+{
+protected:
+    _Stats& _Get_stats() const
+    {
+        return const_cast<_Stats&>(static_cast<const _Stats&>(*this));
+    }
+};
+
+template <class _Stats>
+class _Stats_base<_Stats, false>
+{
+protected:
+    _Stats& _Get_stats() const
+    {
+        return _Mystats;
+    }
+private:
+    mutable _Stats _Mystats;
+};
+
+/// Consolidation policy for rp_heap's _Pass parameter: multipass linking.
+/// pop() files each half tree into the bucket of its rank and, while that
+/// bucket is taken, links the two and carries the winner one rank up. The
+/// root list left behind has at most one half tree per rank.
+///
+/// A policy sees nodes only through _Nodes: _Nodes.rank(p), _Nodes.link(p, q)
+/// and _Nodes.nil(), the empty handle, so the same policy serves pointer
+/// linked and index linked heaps.
+struct rp_heap_multipass
+{
+    // file _Ptr into _Bucket, linking through _Nodes; returns a half tree
+    // that is done for this pop, or nil (never anything here)
+    template <class _Nodeptr, class _Container, class _Nodeview>
+    static _Nodeptr add(_Container& _Bucket, _Nodeptr _Ptr, const _Nodeview& _Nodes)
+    {
+        while (_Bucket[_Nodes.rank(_Ptr)] != _Nodes.nil())
+        {
+            int _Rank = _Nodes.rank(_Ptr);
+            _Ptr = _Nodes.link(_Ptr, _Bucket[_Rank]);
+            _Bucket[_Rank] = _Nodes.nil();
+            // the heaps size the workspace for the largest rank their size
+            // allows; this only guards other callers
+            if ((typename _Container::size_type)_Nodes.rank(_Ptr) >= _Bucket.size())
+                _Bucket.resize(_Nodes.rank(_Ptr) + 1, _Nodes.nil());
+        }
+        _Bucket[_Nodes.rank(_Ptr)] = _Ptr;
+        return _Nodes.nil();
+    }
+};
+
+/// Consolidation policy for rp_heap's _Pass parameter: one-pass linking.
+/// A half tree that meets another of its rank is linked with it once and
+/// the winner goes straight back to the root list, so each pop links fewer
+/// times than multipass, at the price of a longer root list (and more
+/// comparisons) for the next pop. Both keep the heap's amortized bounds.
+struct rp_heap_one_pass
+{
+    template <class _Nodeptr, class _Container, class _Nodeview>
+    static _Nodeptr add(_Container& _Bucket, _Nodeptr _Ptr, const _Nodeview& _Nodes)
+    {
+        _Nodeptr& _Slot = _Bucket[_Nodes.rank(_Ptr)];
+        if (_Slot == _Nodes.nil())
+        {
+            _Slot = _Ptr;
+            return _Nodes.nil();
+        }
+        _Nodeptr _Done = _Nodes.link(_Ptr, _Slot);
+        _Slot = _Nodes.nil();
+        return _Done;
+    }
+};
+
+// a half tree of rank r holds at least F(r + 2) >= phi^r nodes, so a heap of
+// _Count elements has no rank above the largest r with F(r + 2) <= _Count:
+// about 1.44 log2(_Count), not log2(_Count). Returns that r plus 2, the
+// number of rank buckets a consolidation can fill
+inline std::size_t _Rp_bucket_size_for(std::size_t _Count)
+{
+    std::size_t _Rank = 0;
+    std::size_t _Fib = 1, _Fib_next = 2; // F(_Rank + 2), F(_Rank + 3)
+    while (_Fib_next <= _Count)
+    {
+        ++_Rank;
+        if (_Fib_next > std::numeric_limits<std::size_t>::max() - _Fib)
+            break;
+        std::size_t _Sum = _Fib + _Fib_next;
+        _Fib = _Fib_next;
+        _Fib_next = _Sum;
+    }
+    return _Rank + 2;
+}
+
+// rank bucket workspace for a heap that must not allocate: room for every
+// rank any std::size_t count of elements allows (93 buckets), used like a
+// vector whose size() is the part filled since construction
+template <class _Nodeptr>
+class _Rp_fixed_bucket
+{
+public:
+    typedef std::size_t size_type;
+    static const size_type _Capacity = 93;
+
+    size_type size() const
+    {
+        return _Mysize;
+    }
+    void resize(size_type _Count, _Nodeptr _Val)
+    {
+        if (_Count > _Capacity)
+            throw std::length_error("rank bucket error: rank beyond any heap size");
+        for (; _Mysize < _Count; ++_Mysize)
+            _Myelems[_Mysize] = _Val;
+        _Mysize = _Count;
+    }
+    _Nodeptr& operator[](size_type _Idx)
+    {
+        return _Myelems[_Idx];
+    }
+    _Nodeptr* begin()
+    {
+        return _Myelems;
+    }
+    _Nodeptr* end()
+    {
+        return _Myelems + _Mysize;
+    }
+
+private:
+    _Nodeptr _Myelems[_Capacity];
+    size_type _Mysize = 0;
+};
+
+template <class _Nodeptr>
+const std::size_t _Rp_fixed_bucket<_Nodeptr>::_Capacity;
+
+// The node-agnostic algorithm. _Nodes is the heap's node access type, a
+// small copyable view that provides
+//   typedef ... _Nodeptr;                  node handle, a pointer or an index
+//   _Nodeptr nil() const;                  the empty handle
+//   _Nodeptr& left(_Nodeptr) const;        first child
+//   _Nodeptr& next(_Nodeptr) const;        right sibling, or root list link
+//   _Nodeptr& parent(_Nodeptr) const;      null for a root
+//   int& rank(_Nodeptr) const;
+//   bool less(_Nodeptr, _Nodeptr) const;   compares the values
+//   _Stats& stats() const;                 the heap's statistics policy
+// The root list is circular through next() and entered at _Head, the min;
+// _Bucket is a vector-like rank workspace, all nil between operations.
+template <class _Nodes, class _Pass>
+struct _Rp_algo
+{
+    typedef typename _Nodes::_Nodeptr _Nodeptr;
+
+    // what a consolidation policy sees: ranks, the empty handle and link.
+    // _Top follows the highest rank filed, so restoring the roots scans
+    // only the buckets a consolidation can have filled
+    struct _Policy_view
+    {
+        const _Nodes& _Acc;
+        int& _Top;
+        int rank(_Nodeptr _Ptr) const
+        {
+            return _Acc.rank(_Ptr);
+        }
+        _Nodeptr nil() const
+        {
+            return _Acc.nil();
+        }
+        _Nodeptr link(_Nodeptr _Left, _Nodeptr _Right) const
+        {
+            _Nodeptr _Winner = _Link(_Acc, _Left, _Right);
+            _Top = std::max(_Top, _Acc.rank(_Winner));
+            return _Winner;
+        }
+    };
+
+    static bool _Less(const _Nodes& _Acc, _Nodeptr _Left, _Nodeptr _Right)
+    {
+        _Acc.stats().on_compare();
+        return _Acc.less(_Left, _Right);
+    }
+
+    // the rank of a half tree root is one more than its left child's
+    static int _Root_rank(const _Nodes& _Acc, _Nodeptr _Ptr)
+    {
+        _Nodeptr _Left = _Acc.left(_Ptr);
+        return _Left != _Acc.nil() ? _Acc.rank(_Left) + 1 : 0;
+    }
+
+    static void _Insert_root(const _Nodes& _Acc, _Nodeptr& _Head, _Nodeptr _Ptr)
+    {
+        if (_Head == _Acc.nil())
+        {
+            _Head = _Ptr;
+            _Acc.next(_Ptr) = _Ptr;
+        }
+        else
+        {
+            _Acc.next(_Ptr) = _Acc.next(_Head);
+            _Acc.next(_Head) = _Ptr;
+            if (_Less(_Acc, _Ptr, _Head))
+                _Head = _Ptr;
+        }
+    }
+
+    // link two half trees of equal rank; the loser becomes the winner's
+    // left child, its old left subtree the loser's right spine
+    static _Nodeptr _Link(const _Nodes& _Acc, _Nodeptr _Left, _Nodeptr _Right)
+    {
+        _Nodeptr _Winner, _Loser;
+        if (_Less(_Acc, _Right, _Left))
+        {
+            _Winner = _Right;
+            _Loser = _Left;
+        }
+        else
+        {
+            _Winner = _Left;
+            _Loser = _Right;
+        }
+        _Acc.parent(_Loser) = _Winner;
+        if (_Acc.left(_Winner) != _Acc.nil())
+        {
+            _Acc.next(_Loser) = _Acc.left(_Winner);
+            _Acc.parent(_Acc.next(_Loser)) = _Loser;
+        }
+        _Acc.left(_Winner) = _Loser;
+        _Acc.rank(_Winner) = _Acc.rank(_Loser) + 1;
+        _Acc.stats().on_link(_Acc.rank(_Winner));
+        return _Winner;
+    }
+
+    // detach the half tree rooted at the non-root _Ptr, replacing it by its
+    // right spine, and restore the rank rule on the path above it
+    static void _Cut(const _Nodes& _Acc, _Nodeptr _Ptr)
+    {
+        _Nodeptr _ParentPtr = _Acc.parent(_Ptr);
+        _Nodeptr _Spine = _Acc.next(_Ptr);
+        if (_Ptr == _Acc.left(_ParentPtr))
+            _Acc.left(_ParentPtr) = _Spine;
+        else
+            _Acc.next(_ParentPtr) = _Spine;
+        if (_Spine != _Acc.nil())
+            _Acc.parent(_Spine) = _ParentPtr;
+        _Acc.next(_Ptr) = _Acc.parent(_Ptr) = _Acc.nil();
+        _Acc.rank(_Ptr) = _Root_rank(_Acc, _Ptr);
+        while (_Acc.parent(_ParentPtr) != _Acc.nil())
+        {
+            _Nodeptr _L = _Acc.left(_ParentPtr), _R = _Acc.next(_ParentPtr);
+            int i = _L != _Acc.nil() ? _Acc.rank(_L) : -1;
+            int j = _R != _Acc.nil() ? _Acc.rank(_R) : -1;
+#ifdef TYPE1_RANK_REDUCTION
+            int k = (i != j) ? std::max(i, j) : i + 1; //type-1 rank reduction
+#else
+            int k = (std::abs(i - j) > 1) ? std::max(i, j) : std::max(i, j) + 1; //type-2 rank reduction
+#endif // TYPE1_RANK_REDUCTION
+            _Acc.stats().on_rank_reduction_step();
+            if (k >= _Acc.rank(_ParentPtr))
+                return;
+            _Acc.rank(_ParentPtr) = k;
+            _ParentPtr = _Acc.parent(_ParentPtr);
+        }
+        // the cut or the reduction reached a root: its rank follows its
+        // left child
+        _Acc.rank(_ParentPtr) = _Root_rank(_Acc, _ParentPtr);
+    }
+
+    // grow _Bucket to the ranks a heap of _Count elements can reach
+    template <class _Bucket>
+    static void _Prepare_bucket(const _Nodes& _Acc, _Bucket& _Buckets, std::size_t _Count)
+    {
+        std::size_t _Bound = _Rp_bucket_size_for(_Count);
+        if (_Buckets.size() < _Bound)
+            _Buckets.resize(_Bound, _Acc.nil());
+    }
+
+    // hand the detached half tree _Ptr to the consolidation policy; a half
+    // tree it is done with is chained onto _Done through next(), and _Top
+    // is raised to the highest rank it may have filed
+    template <class _Bucket>
+    static void _Consolidate(const _Nodes& _Acc, _Bucket& _Buckets, _Nodeptr _Ptr, _Nodeptr& _Done, int& _Top)
+    {
+        if ((typename _Bucket::size_type)_Acc.rank(_Ptr) >= _Buckets.size())
+            _Buckets.resize(_Acc.rank(_Ptr) + 1, _Acc.nil());
+        _Top = std::max(_Top, _Acc.rank(_Ptr));
+        _Nodeptr _Linked = _Pass::add(_Buckets, _Ptr, _Policy_view{_Acc, _Top});
+        if (_Linked != _Acc.nil())
+        {
+            _Acc.next(_Linked) = _Done;
+            _Done = _Linked;
+        }
+    }
+
+    // detach a former child for consolidation: a new root's rank is one
+    // more than its left child's, since the rank it had as a child also
+    // counted the right spine it just lost
+    template <class _Bucket>
+    static void _Consolidate_child(const _Nodes& _Acc, _Bucket& _Buckets, _Nodeptr _Ptr, _Nodeptr& _Done, int& _Top)
+    {
+        _Acc.next(_Ptr) = _Acc.parent(_Ptr) = _Acc.nil();
+        _Acc.rank(_Ptr) = _Root_rank(_Acc, _Ptr);
+        _Consolidate(_Acc, _Buckets, _Ptr, _Done, _Top);
+    }
+
+    // hand the half trees the policy finished with (_Done) and the linked
+    // ones in the buckets up to rank _Top back to the root list, leaving the
+    // workspace all nil for the next consolidation
+    template <class _Bucket>
+    static void _Restore_roots(const _Nodes& _Acc, _Nodeptr& _Head, _Bucket& _Buckets, _Nodeptr _Done, int _Top)
+    {
+        while (_Done != _Acc.nil())
+        {
+            _Nodeptr _NextPtr = _Acc.next(_Done);
+            _Acc.next(_Done) = _Acc.nil();
+            _Insert_root(_Acc, _Head, _Done);
+            _Done = _NextPtr;
+        }
+        // a one-pass winner goes to _Done, so _Top may pass the buckets
+        std::size_t _End = std::min<std::size_t>(_Top + 1, _Buckets.size());
+        for (std::size_t _Rank = 0; _Rank < _End; ++_Rank)
+        {
+            _Nodeptr& _Ptr = _Buckets[_Rank];
+            if (_Ptr != _Acc.nil())
+            {
+                _Insert_root(_Acc, _Head, _Ptr);
+                _Ptr = _Acc.nil();
+            }
+        }
+    }
+
+    // consolidate the root list and the children of the min of a heap of
+    // _Count elements, and return the old min detached from the heap
+    template <class _Bucket>
+    static _Nodeptr _Unlink_head(const _Nodes& _Acc, _Nodeptr& _Head, _Bucket& _Buckets, std::size_t _Count)
+    {
+        _Prepare_bucket(_Acc, _Buckets, _Count);
+        _Nodeptr _Done = _Acc.nil();
+        int _Top = -1;
+        for (_Nodeptr _Ptr = _Acc.left(_Head); _Ptr != _Acc.nil(); )
+        {
+            _Nodeptr _NextPtr = _Acc.next(_Ptr);
+            _Consolidate_child(_Acc, _Buckets, _Ptr, _Done, _Top);
+            _Ptr = _NextPtr;
+        }
+        std::size_t _Roots = 0;
+        for (_Nodeptr _Ptr = _Acc.next(_Head); _Ptr != _Head; ++_Roots)
+        {
+            _Nodeptr _NextPtr = _Acc.next(_Ptr);
+            _Acc.next(_Ptr) = _Acc.nil();
+            _Consolidate(_Acc, _Buckets, _Ptr, _Done, _Top);
+            _Ptr = _NextPtr;
+        }
+        _Acc.stats().on_consolidate(_Roots);
+        _Nodeptr _Oldhead = _Head;
+        _Head = _Acc.nil();
+        _Restore_roots(_Acc, _Head, _Buckets, _Done, _Top);
+        return _Oldhead;
+    }
+
+    // detach _Ptr from a heap of _Count elements, leaving it a childless
+    // singleton of rank 0
+    template <class _Bucket>
+    static void _Unlink(const _Nodes& _Acc, _Nodeptr& _Head, _Bucket& _Buckets, std::size_t _Count, _Nodeptr _Ptr)
+    {
+        if (_Acc.parent(_Ptr) == _Acc.nil())
+        {
+            // a root has no cheap predecessor in the singly linked root
+            // list: treat it as the min and consolidate, as pop() would
+            _Head = _Ptr;
+            _Unlink_head(_Acc, _Head, _Buckets, _Count);
+        }
+        else
+        {
+            _Cut(_Acc, _Ptr);
+            for (_Nodeptr _Child = _Acc.left(_Ptr); _Child != _Acc.nil(); )
+            {
+                _Nodeptr _NextPtr = _Acc.next(_Child);
+                _Acc.next(_Child) = _Acc.parent(_Child) = _Acc.nil();
+                _Acc.rank(_Child) = _Root_rank(_Acc, _Child);
+                _Insert_root(_Acc, _Head, _Child);
+                _Child = _NextPtr;
+            }
+        }
+        _Acc.left(_Ptr) = _Acc.next(_Ptr) = _Acc.parent(_Ptr) = _Acc.nil();
+        _Acc.rank(_Ptr) = 0;
+    }
+};
+
+#endif /* _RP_HEAP_CORE_H_ */
@@ -0,0 +1,284 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef SSSP_H_
+#define SSSP_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "pool_allocator.h"
+#include "rp_heap.h"
+
+/// Single-source shortest paths over a csr_graph: a sequential Dijkstra
+/// baseline and a parallel delta-stepping engine, both on rp_heap.
+
+using distance_type = std::uint64_t;
+
+/// Distance reported for vertices the source cannot reach.
+constexpr distance_type unreachable = std::numeric_limits<distance_type>::max();
+
+/// Orders vertex ids by their tentative distance. The heap holds vertex ids
+/// only; after lowering dist[v] the caller passes v to rp_heap::decrease(),
+/// which restores the heap order around the node. The one-argument form
+/// is the key function, so by_distance also drives a monotone_heap.
+struct by_distance
+{
+    const distance_type* dist;
+    bool operator()(csr_graph::vertex_type a, csr_graph::vertex_type b) const
+    {
+        return dist[a] < dist[b];
+    }
+    distance_type operator()(csr_graph::vertex_type v) const
+    {
+        return dist[v];
+    }
+};
+
+/// Counters filled in by dijkstra() when a stats pointer is given.
+struct sssp_stats
+{
+    std::size_t pops = 0;
+    std::size_t pushes = 0;
+    std::size_t decreases = 0;
+};
+
+/// Sequential Dijkstra with one heap entry per vertex and decrease-key.
+inline std::vector<distance_type> dijkstra(const csr_graph& g, csr_graph::vertex_type source,
+                                           sssp_stats* stats = nullptr)
+{
+    using vertex = csr_graph::vertex_type;
+    using heap_type = rp_heap<vertex, by_distance, pool_allocator<vertex>>;
+
+    const vertex n = g.num_vertices();
+    std::vector<distance_type> dist(n, unreachable);
+    std::vector<heap_type::const_iterator> handle(n);
+    std::vector<char> state(n, 0); // 0 = unseen, 1 = in heap, 2 = settled
+    sssp_stats local;
+
+    heap_type heap(by_distance{dist.data()});
+    dist[source] = 0;
+    handle[source] = heap.push(source);
+    state[source] = 1;
+    local.pushes++;
+
+    while (!heap.empty())
+    {
+        vertex u;
+        heap.pop(u);
+        state[u] = 2;
+        local.pops++;
+        const distance_type du = dist[u];
+        for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e)
+        {
+            vertex v = g.targets[e];
+            distance_type nd = du + g.weights[e];
+            if (state[v] == 2 || nd >= dist[v])
+                continue;
+            dist[v] = nd;
+            if (state[v] == 1)
+            {
+                heap.decrease(handle[v], v);
+                local.decreases++;
+            }
+            else
+            {
+                handle[v] = heap.push(v);
+                state[v] = 1;
+                local.pushes++;
+            }
+        }
+    }
+    if (stats)
+        *stats = local;
+    return dist;
+}
+
+namespace sssp_detail
+{
+    /// Reusable barrier for a fixed number of threads (std::barrier is C++20).
+    class barrier
+    {
+    public:
+        explicit barrier(unsigned count) : count_(count), waiting_(0), generation_(0) {}
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unsigned gen = generation_;
+            if (++waiting_ == count_)
+            {
+                waiting_ = 0;
+                generation_++;
+                cv_.notify_all();
+            }
+            else
+                cv_.wait(lock, [&] { return gen != generation_; });
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        unsigned count_;
+        unsigned waiting_;
+        unsigned generation_;
+    };
+} // namespace sssp_detail
+
+/// Parallel delta-stepping.
+///
+/// Vertices are partitioned over the threads (v % threads). Each thread owns
+/// the distances of its vertices and keeps them in its own rp_heap, which
+/// plays the role of the delta-wide buckets: the current bucket is every
+/// entry below the smallest (min distance / delta + 1) * delta over all
+/// threads. Relaxation requests are sent to the owning thread through
+/// per-thread-pair outboxes and applied after a barrier with push() or
+/// decrease(), so distances are never written concurrently.
+///
+/// Light edges (weight < delta) are relaxed repeatedly until the bucket is
+/// empty; heavy edges of the vertices settled in the bucket are relaxed
+/// once afterwards. Returns the same distances as dijkstra().
+inline std::vector<distance_type> delta_stepping(const csr_graph& g, csr_graph::vertex_type source,
+                                                 csr_graph::weight_type delta, unsigned threads)
+{
+    using vertex = csr_graph::vertex_type;
+    using heap_type = rp_heap<vertex, by_distance, pool_allocator<vertex>>;
+    using request = std::pair<vertex, distance_type>;
+
+    if (threads == 0)
+        threads = 1;
+    if (delta == 0)
+        delta = 1;
+    const vertex n = g.num_vertices();
+    std::vector<distance_type> dist(n, unreachable);
+    std::vector<heap_type::const_iterator> handle(n);
+    std::vector<char> in_heap(n, 0);
+    std::vector<char> settled_mark(n, 0);
+
+    // outbox[from * threads + to]
+    std::vector<std::vector<request>> outbox(static_cast<std::size_t>(threads) * threads);
+    std::vector<distance_type> local_min(threads);
+    std::vector<char> local_more(threads);
+    sssp_detail::barrier sync(threads);
+
+    auto worker = [&](unsigned t) {
+        heap_type heap(by_distance{dist.data()});
+        std::vector<vertex> settled;
+
+        auto relax = [&](vertex u, bool light) {
+            const distance_type du = dist[u];
+            for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e)
+            {
+                if ((g.weights[e] < delta) != light)
+                    continue;
+                vertex v = g.targets[e];
+                outbox[static_cast<std::size_t>(t) * threads + v % threads].emplace_back(v, du + g.weights[e]);
+            }
+        };
+        auto drain = [&] {
+            for (unsigned s = 0; s < threads; ++s)
+            {
+                std::vector<request>& inbox = outbox[static_cast<std::size_t>(s) * threads + t];
+                for (const request& r : inbox)
+                {
+                    vertex v = r.first;
+                    if (r.second >= dist[v])
+                        continue;
+                    dist[v] = r.second;
+                    if (in_heap[v])
+                        heap.decrease(handle[v], v);
+                    else
+                    {
+                        handle[v] = heap.push(v);
+                        in_heap[v] = 1;
+                    }
+                }
+                inbox.clear();
+            }
+        };
+
+        if (source % threads == t)
+        {
+            dist[source] = 0;
+            handle[source] = heap.push(source);
+            in_heap[source] = 1;
+        }
+        for (;;)
+        {
+            local_min[t] = heap.empty() ? unreachable : dist[heap.top()];
+            sync.wait();
+            distance_type lowest = *std::min_element(local_min.begin(), local_min.end());
+            if (lowest == unreachable)
+                break;
+            const distance_type bound = (lowest / delta + 1) * delta;
+
+            // light phase: repeat until no thread has entries in the bucket
+            for (;;)
+            {
+                while (!heap.empty() && dist[heap.top()] < bound)
+                {
+                    vertex u;
+                    heap.pop(u);
+                    in_heap[u] = 0;
+                    if (!settled_mark[u])
+                    {
+                        settled_mark[u] = 1;
+                        settled.push_back(u);
+                    }
+                    relax(u, true);
+                }
+                sync.wait();
+                drain();
+                local_more[t] = !heap.empty() && dist[heap.top()] < bound;
+                sync.wait();
+                if (std::find(local_more.begin(), local_more.end(), 1) == local_more.end())
+                    break;
+            }
+
+            // heavy phase: distances in the bucket are final now
+            for (vertex u : settled)
+            {
+                relax(u, false);
+                settled_mark[u] = 0;
+            }
+            settled.clear();
+            sync.wait();
+            drain();
+            sync.wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& th : pool)
+        th.join();
+    return dist;
+}
+
+#endif /* SSSP_H_ */
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "astar.h"
+#include "astar_batch.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// a path is valid if it starts and ends at the query's cells and every
+// step moves to a passable neighbour without cutting a corner
+static bool valid_path(const grid_map& map, const std::deque<Node>& path, const scenario& sc, double* cost) {
+    if (path.empty() || path.front().x != sc.start_x || path.front().y != sc.start_y ||
+        path.back().x != sc.goal_x || path.back().y != sc.goal_y)
+        return false;
+    *cost = 0;
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        int dx = path[i].x - path[i - 1].x, dy = path[i].y - path[i - 1].y;
+        if (std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0))
+            return false;
+        if (map[path[i].y][path[i].x] != 0)
+            return false;
+        if (dx && dy && (map[path[i - 1].y][path[i].x] || map[path[i].y][path[i - 1].x]))
+            return false;
+        *cost += (dx && dy) ? SQRT2 : 1;
+    }
+    return true;
+}
+
+TEST(AStar, MovingAiMapAndScenarioFiles) {
+    std::istringstream map_file(
+        "type octile\n"
+        "height 3\n"
+        "width 4\n"
+        "map\n"
+        "..@.\n"
+        ".T..\n"
+        "....\n");
+    grid_map map;
+    int L, W;
+    ASSERT_TRUE(load_movingai_map(map_file, map, L, W));
+    EXPECT_EQ(L, 4);
+    EXPECT_EQ(W, 3);
+    EXPECT_EQ(map[0][2], 1);
+    EXPECT_EQ(map[1][1], 1);
+    EXPECT_EQ(map[2][3], 0);
+
+    std::vector<scenario> in = {{0, 0, 3, 0, 5.0}, {0, 2, 3, 2, 3.0}};
+    std::ostringstream out;
+    write_scenarios(out, "tiny.map", L, W, in);
+    std::istringstream scen_file(out.str());
+    std::vector<scenario> loaded;
+    ASSERT_TRUE(load_scenarios(scen_file, loaded));
+    ASSERT_EQ(loaded.size(), 2u);
+    EXPECT_EQ(loaded[0].goal_x, 3);
+    EXPECT_DOUBLE_EQ(loaded[1].optimal, 3.0);
+
+    for (const scenario& sc : loaded) {
+        astar_stats stats;
+        auto path = shortest_path_a_star(map, L, W, Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y), &stats);
+        double cost;
+        ASSERT_TRUE(valid_path(map, path, sc, &cost));
+        EXPECT_NEAR(cost, stats.cost, 1e-9);
+        EXPECT_GT(stats.expansions, 0u);
+    }
+}
+
+TEST(AStar, GeneratedScenariosAreReachable) {
+    grid_map map = make_random_map(64, 48, 0.3, 5);
+    std::vector<scenario> queries = generate_scenarios(map, 64, 48, 200, 11);
+    ASSERT_EQ(queries.size(), 200u);
+    for (const scenario& sc : queries) {
+        astar_stats stats;
+        auto path = shortest_path_a_star(map, 64, 48, Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y), &stats);
+        double cost;
+        ASSERT_TRUE(valid_path(map, path, sc, &cost));
+        EXPECT_NEAR(cost, stats.cost, 1e-9);
+    }
+}
+
+TEST(AStar, UnreachableGoalGivesEmptyPath) {
+    grid_map map = {{0, 1, 0}, {0, 1, 0}, {0, 1, 0}};
+    astar_stats stats;
+    auto path = shortest_path_a_star(map, 3, 3, Node(0, 0), Node(2, 2), &stats);
+    EXPECT_TRUE(path.empty());
+    EXPECT_EQ(stats.cost, -1);
+    EXPECT_EQ(stats.expansions, 3u);
+}
+
+TEST(AStar, GridEngineMatchesFunctionAndReusesState) {
+    grid_map map = make_random_map(80, 60, 0.3, 8);
+    std::vector<scenario> queries = generate_scenarios(map, 80, 60, 300, 2);
+    GridAStar engine(map, 80, 60);
+    std::vector<Node> path;
+    // twice over the queries, so the second pass runs on stamped state
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const scenario& sc : queries) {
+            astar_stats expected_stats, stats;
+            auto expected = shortest_path_a_star(map, 80, 60, Node(sc.start_x, sc.start_y),
+                                                 Node(sc.goal_x, sc.goal_y), &expected_stats);
+            ASSERT_TRUE(engine.search(sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, path, &stats));
+            ASSERT_EQ(path.size(), expected.size());
+            for (std::size_t i = 0; i < path.size(); ++i) {
+                EXPECT_EQ(path[i].x, expected[i].x);
+                EXPECT_EQ(path[i].y, expected[i].y);
+            }
+            EXPECT_EQ(stats.cost, expected_stats.cost);
+            EXPECT_EQ(stats.expansions, expected_stats.expansions);
+        }
+    }
+    grid_map walled = {{0, 1, 0}, {0, 1, 0}, {0, 1, 0}};
+    GridAStar blocked(walled, 3, 3);
+    EXPECT_FALSE(blocked.search(0, 0, 2, 2, path));
+    EXPECT_TRUE(path.empty());
+    EXPECT_EQ(blocked.find_path(Node(0, 0), Node(0, 2)).size(), 3u);
+}
+
+// an open grid whose blocked() throws at one cell while armed
+struct PoisonedGrid {
+    static std::atomic<bool> armed;
+    int width() const { return 20; }
+    int height() const { return 20; }
+    std::size_t cells() const { return 400; }
+    bool blocked(int x, int y) const {
+        if (armed.load() && x == 10 && y == 10)
+            throw std::runtime_error("poisoned cell");
+        return false;
+    }
+};
+std::atomic<bool> PoisonedGrid::armed{false};
+
+TEST(AStar, BatchRethrowsAfterWorkersFinish) {
+    std::vector<path_query> queries;
+    for (int i = 0; i < 200; ++i)
+        queries.emplace_back(i % 3 ? Node(0, 0) : Node(0, 19), Node(19, 19 - i % 20));
+    for (unsigned threads : {1u, 2u, 4u}) {
+        BasicBatchAStar<PoisonedGrid> batch(std::make_shared<const PoisonedGrid>(), threads);
+        std::vector<path_result> results;
+        PoisonedGrid::armed = true;
+        EXPECT_THROW(batch.run(queries, results), std::runtime_error);
+        // the pool is idle again and the error does not leak into the next batch
+        PoisonedGrid::armed = false;
+        batch.run(queries, results);
+        for (const path_result& r : results)
+            EXPECT_FALSE(r.path.empty());
+    }
+}
+
+TEST(AStar, BatchMatchesEngineInInputOrder) {
+    grid_map map = make_random_map(80, 60, 0.3, 9);
+    std::vector<scenario> scenarios = generate_scenarios(map, 80, 60, 400, 3);
+    std::vector<path_query> queries;
+    for (const scenario& sc : scenarios)
+        queries.emplace_back(Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y));
+    // one unreachable query in the middle of the batch: its goal is an obstacle
+    int wall = 0;
+    while (map[wall / 80][wall % 80] == 0)
+        wall++;
+    queries.insert(queries.begin() + 100, path_query(queries[0].first, Node(wall % 80, wall / 80)));
+
+    GridAStar engine(map, 80, 60);
+    std::vector<std::vector<Node>> expected(queries.size());
+    std::vector<astar_stats> expected_stats(queries.size());
+    for (std::size_t i = 0; i < queries.size(); ++i)
+        engine.search(queries[i].first.x, queries[i].first.y, queries[i].second.x, queries[i].second.y,
+                      expected[i], &expected_stats[i]);
+    EXPECT_TRUE(expected[100].empty());
+
+    for (unsigned threads : {1u, 2u, 4u}) {
+        BatchAStar batch(engine.map(), threads);
+        EXPECT_EQ(batch.threads(), threads);
+        std::vector<path_result> results;
+        // the second batch reuses the workers and the result buffers
+        for (int pass = 0; pass < 2; ++pass) {
+            batch.run(queries, results);
+            ASSERT_EQ(results.size(), queries.size());
+            for (std::size_t i = 0; i < queries.size(); ++i) {
+                ASSERT_EQ(results[i].path.size(), expected[i].size()) << "query " << i;
+                for (std::size_t k = 0; k < expected[i].size(); ++k) {
+                    EXPECT_EQ(results[i].path[k].x, expected[i][k].x);
+                    EXPECT_EQ(results[i].path[k].y, expected[i][k].y);
+                }
+                EXPECT_EQ(results[i].stats.cost, expected_stats[i].cost);
+                EXPECT_EQ(results[i].stats.expansions, expected_stats[i].expansions);
+            }
+        }
+        EXPECT_TRUE(batch.run(std::vector<path_query>()).empty());
+    }
+}
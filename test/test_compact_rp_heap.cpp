@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "compact_rp_heap.h"
+#include "rp_heap.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------- basic operations ----------
+
+TEST(CompactRpHeap, NodeIsSmallerThanPointerNode) {
+    EXPECT_LT(sizeof(_Compact_node<int>), sizeof(_Node<int>));
+    EXPECT_LE(sizeof(_Compact_node<int>), 20u);
+}
+
+TEST(CompactRpHeap, PushTopSizeEmpty) {
+    compact_rp_heap<int> h;
+    EXPECT_TRUE(h.empty());
+    EXPECT_EQ(h.size(), 0u);
+
+    h.push(42);
+    EXPECT_EQ(h.size(), 1u);
+    EXPECT_EQ(h.top(), 42);
+
+    h.push(10);
+    h.push(99);
+    EXPECT_EQ(h.size(), 3u);
+    EXPECT_EQ(h.top(), 10);
+}
+
+TEST(CompactRpHeap, PopExtractMinOrdering) {
+    compact_rp_heap<int> h;
+    std::mt19937 rng(12345);
+    std::vector<int> vals;
+    for (int i = 0; i < 2000; ++i) {
+        int v = static_cast<int>(rng() % 100000);
+        vals.push_back(v);
+        h.push(v);
+    }
+    std::sort(vals.begin(), vals.end());
+    for (int v : vals) {
+        ASSERT_FALSE(h.empty());
+        EXPECT_EQ(h.top(), v);
+        h.pop();
+    }
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(CompactRpHeap, PopOnEmptyThrows) {
+    compact_rp_heap<int> h;
+    EXPECT_THROW(h.pop(), std::runtime_error);
+    int val;
+    EXPECT_THROW(h.pop(val), std::runtime_error);
+}
+
+TEST(CompactRpHeap, MoveOnlyFriendlyValues) {
+    compact_rp_heap<std::string> h;
+    h.push(std::string("pear"));
+    h.push(std::string("apple"));
+    std::string s;
+    h.pop(s);
+    EXPECT_EQ(s, "apple");
+    h.push(std::string("fig")); // reuses the freed slot
+    h.pop(s);
+    EXPECT_EQ(s, "fig");
+    EXPECT_EQ(h.top(), "pear");
+}
+
+TEST(CompactRpHeap, PopDestroysValueAtOnce) {
+    auto a = std::make_shared<int>(1);
+    auto b = std::make_shared<int>(2);
+    struct Less {
+        bool operator()(const std::shared_ptr<int>& l, const std::shared_ptr<int>& r) const { return *l < *r; }
+    };
+    compact_rp_heap<std::shared_ptr<int>, Less> h;
+    h.push(a);
+    h.push(b);
+    EXPECT_EQ(a.use_count(), 2);
+    h.pop();
+    EXPECT_EQ(a.use_count(), 1); // not held by the free slot
+    h.push(a);                   // reuses that slot
+    EXPECT_EQ(a.use_count(), 2);
+    h.clear();
+    EXPECT_EQ(a.use_count(), 1);
+    EXPECT_EQ(b.use_count(), 1);
+}
+
+struct Unassignable {
+    explicit Unassignable(int v) : key(v) {}
+    const int key;
+    bool operator<(const Unassignable& r) const { return key < r.key; }
+};
+
+TEST(CompactRpHeap, ReusedSlotsConstructTheirValue) {
+    compact_rp_heap<Unassignable> h;
+    for (int i = 0; i < 100; ++i)
+        h.push(Unassignable(100 - i));
+    for (int round = 0; round < 50; ++round) {
+        h.pop();
+        h.push(Unassignable(1000 + round));
+    }
+    EXPECT_EQ(h.top().key, 51);
+    EXPECT_EQ(h.size(), 100u);
+}
+
+TEST(CompactRpHeap, ClearAndReuse) {
+    compact_rp_heap<int> h;
+    for (int i = 0; i < 100; ++i)
+        h.push(i);
+    h.clear();
+    EXPECT_TRUE(h.empty());
+    h.push(3);
+    h.push(1);
+    EXPECT_EQ(h.top(), 1);
+}
+
+// ---------- decrease key ----------
+
+TEST(CompactRpHeap, HandlesSurviveSlabGrowth) {
+    compact_rp_heap<int> h;
+    auto it = h.push(500);
+    for (int i = 0; i < 10000; ++i)
+        h.push(1000 + i);
+    EXPECT_EQ(*it, 500);
+    h.decrease(it, 1);
+    EXPECT_EQ(h.top(), 1);
+}
+
+TEST(CompactRpHeap, MatchesRpHeapUnderDecreaseAndPop) {
+    // value = key * N + id keeps values unique so a popped id is known
+    const int N = 3000;
+    compact_rp_heap<long long> c;
+    rp_heap<long long> r;
+    std::vector<compact_rp_heap<long long>::const_iterator> cits;
+    std::vector<rp_heap<long long>::const_iterator> rits;
+    std::vector<bool> alive(N, true);
+    std::mt19937 rng(777);
+
+    for (int i = 0; i < N; ++i) {
+        long long v = static_cast<long long>(rng() % 1000000) * N + i;
+        cits.push_back(c.push(v));
+        rits.push_back(r.push(v));
+    }
+    for (int round = 0; round < 1500; ++round) {
+        int i = static_cast<int>(rng() % N);
+        if (alive[i]) {
+            long long v = *cits[i] - static_cast<long long>(rng() % 1000) * N;
+            c.decrease(cits[i], v);
+            r.decrease(rits[i], v);
+        }
+        if (round % 3 == 0) {
+            ASSERT_EQ(c.top(), r.top());
+            alive[((c.top() % N) + N) % N] = false;
+            c.pop();
+            r.pop();
+        }
+    }
+    while (!r.empty()) {
+        ASSERT_EQ(c.top(), r.top());
+        c.pop();
+        r.pop();
+    }
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(CompactRpHeap, CustomComparatorMaxHeap) {
+    compact_rp_heap<int, std::greater<int>> h;
+    h.push(10);
+    h.push(30);
+    h.push(20);
+    EXPECT_EQ(h.top(), 30);
+    h.pop();
+    EXPECT_EQ(h.top(), 20);
+}
+
+// compact_rp_heap runs the same core as rp_heap: with the same operations
+// every counter agrees, under either consolidation policy
+template <class Pass>
+void ExpectSameCountsAsRpHeap() {
+    const int N = 3000;
+    compact_rp_heap<long long, std::less<long long>, std::allocator<long long>, rp_heap_counting_stats, Pass> c;
+    rp_heap<long long, std::less<long long>, std::allocator<long long>, rp_heap_counting_stats, Pass> r;
+    std::vector<typename decltype(c)::const_iterator> cits;
+    std::vector<typename decltype(r)::const_iterator> rits;
+    std::vector<bool> alive(N, true);
+    std::mt19937 rng(4242);
+    for (int i = 0; i < N; ++i) {
+        long long v = static_cast<long long>(rng() % 1000000) * N + i;
+        cits.push_back(c.push(v));
+        rits.push_back(r.push(v));
+    }
+    for (int round = 0; round < 3000; ++round) {
+        int i = static_cast<int>(rng() % N);
+        if (alive[i]) {
+            long long v = *cits[i] - static_cast<long long>(rng() % 1000) * N;
+            c.decrease(cits[i], v);
+            r.decrease(rits[i], v);
+        }
+        if (round % 2 == 0) {
+            ASSERT_EQ(c.top(), r.top());
+            alive[((c.top() % N) + N) % N] = false;
+            c.pop();
+            r.pop();
+        }
+    }
+    rp_heap_stats got = c.stats(), want = r.stats();
+    EXPECT_GT(got.rank_reduction_steps, 0u);
+    EXPECT_EQ(got.comparisons, want.comparisons);
+    EXPECT_EQ(got.links, want.links);
+    EXPECT_EQ(got.consolidations, want.consolidations);
+    EXPECT_EQ(got.roots_scanned, want.roots_scanned);
+    EXPECT_EQ(got.max_roots, want.max_roots);
+    EXPECT_EQ(got.rank_reduction_steps, want.rank_reduction_steps);
+    EXPECT_EQ(got.max_rank, want.max_rank);
+}
+
+TEST(CompactRpHeap, CountsMatchRpHeapMultipass) {
+    ExpectSameCountsAsRpHeap<rp_heap_multipass>();
+}
+
+TEST(CompactRpHeap, CountsMatchRpHeapOnePass) {
+    ExpectSameCountsAsRpHeap<rp_heap_one_pass>();
+}
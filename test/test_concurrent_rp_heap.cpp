@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "concurrent_rp_heap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// ---------- single-threaded behaviour ----------
+
+TEST(ConcurrentRpHeap, SingleShardIsExact) {
+    concurrent_rp_heap<int> h(1);
+    EXPECT_EQ(h.shard_count(), 1u);
+    std::mt19937 rng(1);
+    std::vector<int> vals;
+    for (int i = 0; i < 1000; ++i) {
+        int v = static_cast<int>(rng() % 10000);
+        vals.push_back(v);
+        h.push(v);
+    }
+    EXPECT_EQ(h.size(), 1000u);
+    std::sort(vals.begin(), vals.end());
+    for (int v : vals) {
+        int x;
+        ASSERT_TRUE(h.try_pop(x));
+        EXPECT_EQ(x, v);
+    }
+    int x;
+    EXPECT_FALSE(h.try_pop(x));
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(ConcurrentRpHeap, ShardedReturnsEveryElementOnce) {
+    concurrent_rp_heap<int> h(8);
+    for (int i = 0; i < 5000; ++i)
+        h.push(i);
+    std::vector<int> out;
+    int x;
+    while (h.try_pop(x))
+        out.push_back(x);
+    ASSERT_EQ(out.size(), 5000u);
+    std::sort(out.begin(), out.end());
+    for (int i = 0; i < 5000; ++i)
+        EXPECT_EQ(out[i], i);
+}
+
+TEST(ConcurrentRpHeap, ShardedOrderIsApproximatelySorted) {
+    // two-choice pops keep the returned elements near the front: with 8
+    // shards no popped element should be far from the current minimum
+    const int N = 20000;
+    concurrent_rp_heap<int> h(8);
+    std::vector<int> keys(N);
+    for (int i = 0; i < N; ++i)
+        keys[i] = i;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+    for (int k : keys)
+        h.push(k);
+    std::vector<bool> taken(N, false);
+    int front = 0;
+    long long total_error = 0;
+    int x;
+    while (h.try_pop(x)) {
+        while (front < N && taken[front])
+            front++;
+        total_error += x - front;
+        taken[x] = true;
+    }
+    EXPECT_LT(static_cast<double>(total_error) / N, 64.0);
+}
+
+TEST(ConcurrentRpHeap, MaxHeapComparator) {
+    concurrent_rp_heap<int, std::greater<int>> h(1);
+    h.push(1);
+    h.push(3);
+    h.push(2);
+    int x;
+    ASSERT_TRUE(h.try_pop(x));
+    EXPECT_EQ(x, 3);
+}
+
+// copying or assigning one throws while the matching flag is set
+struct Fragile {
+    static bool throw_on_copy, throw_on_assign;
+    int v;
+    explicit Fragile(int x) : v(x) {}
+    Fragile(const Fragile& r) : v(r.v) {
+        if (throw_on_copy)
+            throw std::runtime_error("copy");
+    }
+    Fragile& operator=(const Fragile& r) {
+        if (throw_on_assign)
+            throw std::runtime_error("assign");
+        v = r.v;
+        return *this;
+    }
+    bool operator<(const Fragile& r) const { return v < r.v; }
+};
+bool Fragile::throw_on_copy = false;
+bool Fragile::throw_on_assign = false;
+
+TEST(ConcurrentRpHeap, ThrowingValueReleasesShardLocks) {
+    // a shard left locked would make the operations after the throw spin
+    // forever, so reaching the end is the check
+    for (std::size_t shards : {1u, 2u}) {
+        concurrent_rp_heap<Fragile> h(shards);
+        Fragile a(1), b(2);
+        h.push(a);
+        h.push(b);
+        Fragile::throw_on_copy = true;
+        EXPECT_THROW(h.push(a), std::runtime_error);
+        Fragile::throw_on_copy = false;
+        EXPECT_EQ(h.size(), 2u);
+
+        Fragile out(0);
+        Fragile::throw_on_assign = true;
+        EXPECT_THROW(h.try_pop(out), std::runtime_error);
+        Fragile::throw_on_assign = false;
+        EXPECT_EQ(h.size(), 2u); // the failed pop kept its element
+
+        h.push(Fragile(0));
+        std::vector<int> got;
+        while (h.try_pop(out))
+            got.push_back(out.v);
+        std::sort(got.begin(), got.end());
+        EXPECT_EQ(got, (std::vector<int>{0, 1, 2}));
+    }
+}
+
+// ---------- multi-threaded ----------
+
+TEST(ConcurrentRpHeap, ProducersAndConsumers) {
+    const int kProducers = 4, kConsumers = 4, kPerProducer = 20000;
+    const int kTotal = kProducers * kPerProducer;
+    concurrent_rp_heap<int> h(16);
+    std::vector<std::atomic<int>> seen(kTotal);
+    for (auto& s : seen)
+        s.store(0);
+    std::atomic<int> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p)
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; ++i)
+                h.push(p * kPerProducer + i);
+        });
+    for (int c = 0; c < kConsumers; ++c)
+        threads.emplace_back([&] {
+            int x;
+            while (popped.load() < kTotal) {
+                if (h.try_pop(x)) {
+                    seen[x].fetch_add(1);
+                    popped.fetch_add(1);
+                }
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(popped.load(), kTotal);
+    EXPECT_TRUE(h.empty());
+    for (int i = 0; i < kTotal; ++i)
+        ASSERT_EQ(seen[i].load(), 1) << "value " << i;
+}
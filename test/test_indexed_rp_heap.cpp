@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "indexed_rp_heap.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+TEST(IndexedRpHeap, PushContainsPop) {
+    indexed_rp_heap<double> heap(10);
+    EXPECT_EQ(heap.capacity(), 10u);
+    EXPECT_TRUE(heap.empty());
+    heap.push(7, 3.5);
+    heap.push(2, 1.25);
+    heap.push(9, 8.0);
+    EXPECT_TRUE(heap.contains(7));
+    EXPECT_FALSE(heap.contains(3));
+    EXPECT_EQ(heap.size(), 3u);
+    EXPECT_EQ(heap.top(), 2u);
+    EXPECT_DOUBLE_EQ(heap.top_key(), 1.25);
+    EXPECT_DOUBLE_EQ(heap.key(9), 8.0);
+    EXPECT_THROW(heap.push(7, 0.0), std::invalid_argument);
+    EXPECT_EQ(heap.pop(), 2u);
+    EXPECT_FALSE(heap.contains(2));
+    EXPECT_EQ(heap.pop(), 7u);
+    EXPECT_EQ(heap.pop(), 9u);
+    EXPECT_THROW(heap.pop(), std::runtime_error);
+    // a popped id can be pushed again
+    heap.push(2, 4.0);
+    EXPECT_EQ(heap.top(), 2u);
+}
+
+TEST(IndexedRpHeap, DecreaseEraseAndClear) {
+    indexed_rp_heap<int, std::greater<int>> heap(5);
+    for (int id = 0; id < 5; ++id)
+        heap.push(id, id * 10);
+    EXPECT_EQ(heap.top(), 4u);
+    heap.decrease(1, 100); // "decrease" under greater<> raises the key
+    EXPECT_EQ(heap.top(), 1u);
+    heap.decrease(1, 50);  // ignored
+    EXPECT_EQ(heap.key(1), 100);
+    heap.erase(1);
+    EXPECT_FALSE(heap.contains(1));
+    EXPECT_EQ(heap.top(), 4u);
+    heap.clear();
+    EXPECT_TRUE(heap.empty());
+    for (int id = 0; id < 5; ++id)
+        EXPECT_FALSE(heap.contains(id));
+}
+
+// interleaved operations against std::set of (key, id)
+TEST(IndexedRpHeap, RandomOperationsMatchSet) {
+    const std::size_t n = 5000;
+    indexed_rp_heap<long> heap(n);
+    std::set<std::pair<long, std::size_t>> ref;
+    std::mt19937 rng(4);
+    for (int step = 0; step < 60000; ++step) {
+        std::size_t id = rng() % n;
+        unsigned op = rng() % 4;
+        if (!heap.contains(id)) {
+            long k = static_cast<long>(rng() % 1000000);
+            heap.push(id, k);
+            ref.insert({k, id});
+        } else if (op == 0) {
+            ref.erase({heap.key(id), id});
+            heap.erase(id);
+        } else if (op == 1) {
+            long k = heap.key(id) - static_cast<long>(rng() % 5000);
+            ref.erase({heap.key(id), id});
+            heap.decrease(id, k);
+            ref.insert({k, id});
+        } else {
+            ASSERT_EQ(heap.top_key(), ref.begin()->first);
+            std::size_t top = heap.pop();
+            ASSERT_EQ(ref.erase({ref.begin()->first, top}), 1u);
+        }
+        ASSERT_EQ(heap.size(), ref.size());
+    }
+}
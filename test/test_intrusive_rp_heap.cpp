@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "intrusive_rp_heap.h"
+#include "rp_heap.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+struct task {
+    int deadline = 0;
+    int id = 0;
+    rp_heap_hook<task> hook;
+    bool operator<(const task& o) const { return deadline < o.deadline; }
+};
+
+typedef intrusive_rp_heap<task, &task::hook> task_heap;
+
+TEST(IntrusiveRpHeap, PushPopInOrder) {
+    std::vector<task> tasks(1000);
+    std::mt19937 rng(5);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].deadline = static_cast<int>(rng() % 10000);
+        tasks[i].id = static_cast<int>(i);
+    }
+    task_heap heap;
+    for (task& t : tasks) {
+        EXPECT_FALSE(t.hook.is_linked());
+        heap.push(t);
+        EXPECT_TRUE(t.hook.is_linked());
+    }
+    EXPECT_EQ(heap.size(), tasks.size());
+    int last = -1;
+    while (!heap.empty()) {
+        task& t = heap.top();
+        EXPECT_GE(t.deadline, last);
+        last = t.deadline;
+        heap.pop();
+        EXPECT_FALSE(t.hook.is_linked());
+    }
+    EXPECT_THROW(heap.pop(), std::runtime_error);
+}
+
+TEST(IntrusiveRpHeap, DecreaseAndErase) {
+    std::vector<task> tasks(5);
+    for (int i = 0; i < 5; ++i)
+        tasks[i].deadline = (i + 1) * 10;
+    task_heap heap;
+    for (task& t : tasks)
+        heap.push(t);
+    heap.pop(); // 10
+    tasks[4].deadline = 1;
+    heap.decrease(tasks[4]);
+    EXPECT_EQ(&heap.top(), &tasks[4]);
+    heap.erase(tasks[4]);
+    EXPECT_FALSE(tasks[4].hook.is_linked());
+    EXPECT_EQ(heap.top().deadline, 20);
+    // raising a key: erase and push again
+    heap.erase(tasks[1]);
+    tasks[1].deadline = 100;
+    heap.push(tasks[1]);
+    std::vector<int> order;
+    while (!heap.empty()) {
+        order.push_back(heap.top().deadline);
+        heap.pop();
+    }
+    EXPECT_EQ(order, (std::vector<int>{30, 40, 100}));
+}
+
+TEST(IntrusiveRpHeap, ClearUnlinksEveryElement) {
+    std::vector<task> tasks(3000);
+    std::mt19937 rng(9);
+    task_heap heap;
+    for (task& t : tasks) {
+        t.deadline = static_cast<int>(rng() % 100000);
+        heap.push(t);
+    }
+    for (int i = 0; i < 100; ++i)
+        heap.pop(); // build up half trees
+    heap.clear();
+    EXPECT_TRUE(heap.empty());
+    for (const task& t : tasks)
+        EXPECT_FALSE(t.hook.is_linked());
+    // the elements can go straight into another heap
+    task_heap other;
+    for (task& t : tasks)
+        other.push(t);
+    EXPECT_EQ(other.size(), tasks.size());
+}
+
+TEST(IntrusiveRpHeap, CopiedElementsStartUnlinked) {
+    task a;
+    task_heap heap;
+    heap.push(a);
+    task b = a;
+    EXPECT_TRUE(a.hook.is_linked());
+    EXPECT_FALSE(b.hook.is_linked());
+}
+
+// interleaved operations against std::set of (deadline, id)
+TEST(IntrusiveRpHeap, RandomOperationsMatchSet) {
+    std::vector<task> tasks(2000);
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+        tasks[i].id = static_cast<int>(i);
+    std::set<std::pair<int, int>> ref;
+    task_heap heap;
+    std::mt19937 rng(21);
+    for (int step = 0; step < 40000; ++step) {
+        task& t = tasks[rng() % tasks.size()];
+        unsigned op = rng() % 4;
+        if (!t.hook.is_linked()) {
+            t.deadline = static_cast<int>(rng() % 100000);
+            heap.push(t);
+            ref.insert({t.deadline, t.id});
+        } else if (op == 0) {
+            ref.erase({t.deadline, t.id});
+            heap.erase(t);
+        } else if (op == 1) {
+            ref.erase({t.deadline, t.id});
+            t.deadline -= static_cast<int>(rng() % 1000);
+            heap.decrease(t);
+            ref.insert({t.deadline, t.id});
+        } else if (!heap.empty()) {
+            ASSERT_EQ(heap.top().deadline, ref.begin()->first);
+            ref.erase({heap.top().deadline, heap.top().id});
+            heap.pop();
+        }
+        ASSERT_EQ(heap.size(), ref.size());
+    }
+}
+
+// the shared core runs the same links and cuts as rp_heap, so under the same
+// operations the counters agree; rp_heap's decrease also compares the new
+// value with the old one
+template <class Pass>
+void ExpectSameCountsAsRpHeap() {
+    typedef intrusive_rp_heap<task, &task::hook, std::less<task>, rp_heap_counting_stats, Pass> counted_heap;
+    const int N = 3000;
+    std::vector<task> tasks(N);
+    std::vector<typename rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats, Pass>::const_iterator>
+        its(N);
+    counted_heap heap;
+    rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats, Pass> ref;
+    std::mt19937 rng(33);
+    unsigned long long decreases = 0;
+    // deadline = key * N + id keeps the values unique
+    for (int i = 0; i < N; ++i) {
+        tasks[i].id = i;
+        tasks[i].deadline = static_cast<int>(rng() % 100000) * N + i;
+        heap.push(tasks[i]);
+        its[i] = ref.push(tasks[i].deadline);
+    }
+    for (int step = 0; step < 6000; ++step) {
+        task& t = tasks[rng() % N];
+        unsigned op = rng() % 3;
+        if (!t.hook.is_linked())
+            continue;
+        if (op == 0) {
+            heap.erase(t);
+            ref.erase(its[t.id]);
+        } else if (op == 1) {
+            t.deadline -= static_cast<int>(rng() % 1000) * N;
+            heap.decrease(t);
+            ref.decrease(its[t.id], t.deadline);
+            ++decreases;
+        } else {
+            ASSERT_EQ(heap.top().deadline, ref.top());
+            heap.pop();
+            ref.pop();
+        }
+    }
+    rp_heap_stats got = heap.stats(), want = ref.stats();
+    EXPECT_GT(got.links, 0u);
+    EXPECT_EQ(got.comparisons + decreases, want.comparisons);
+    EXPECT_EQ(got.links, want.links);
+    EXPECT_EQ(got.consolidations, want.consolidations);
+    EXPECT_EQ(got.roots_scanned, want.roots_scanned);
+    EXPECT_EQ(got.rank_reduction_steps, want.rank_reduction_steps);
+    EXPECT_EQ(got.max_rank, want.max_rank);
+    heap.reset_stats();
+    EXPECT_EQ(heap.stats().comparisons, 0u);
+}
+
+TEST(IntrusiveRpHeap, CountsMatchRpHeapMultipass) {
+    ExpectSameCountsAsRpHeap<rp_heap_multipass>();
+}
+
+TEST(IntrusiveRpHeap, CountsMatchRpHeapOnePass) {
+    ExpectSameCountsAsRpHeap<rp_heap_one_pass>();
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "keyed_rp_heap.h"
+#include "pool_allocator.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+struct record {
+    int priority;
+    std::string name;
+};
+
+struct by_priority {
+    int operator()(const record* r) const { return r->priority; }
+};
+
+// counts how often the key function runs, i.e. how often a value is read
+struct counting_key {
+    int* calls;
+    int operator()(const record* r) const {
+        ++*calls;
+        return r->priority;
+    }
+};
+
+TEST(KeyedRpHeap, PopsInKeyOrder) {
+    std::mt19937 rng(3);
+    std::vector<record> records(2000);
+    for (std::size_t i = 0; i < records.size(); ++i)
+        records[i] = {static_cast<int>(rng() % 100000), std::to_string(i)};
+    keyed_rp_heap<const record*, by_priority> heap;
+    for (const record& r : records)
+        heap.push(&r);
+    EXPECT_EQ(heap.size(), records.size());
+    std::vector<int> expected;
+    for (const record& r : records)
+        expected.push_back(r.priority);
+    std::sort(expected.begin(), expected.end());
+    for (int p : expected) {
+        ASSERT_EQ(heap.top_key(), p);
+        const record* r;
+        heap.pop(r);
+        EXPECT_EQ(r->priority, p);
+    }
+    EXPECT_TRUE(heap.empty());
+    EXPECT_THROW(heap.pop(), std::runtime_error);
+}
+
+TEST(KeyedRpHeap, KeyIsReadOncePerPush) {
+    std::vector<record> records;
+    for (int i = 0; i < 500; ++i)
+        records.push_back({(i * 7919) % 500, ""});
+    int calls = 0;
+    keyed_rp_heap<const record*, counting_key> heap(counting_key{&calls});
+    for (const record& r : records)
+        heap.push(&r);
+    while (!heap.empty())
+        heap.pop();
+    EXPECT_EQ(calls, 500);
+}
+
+TEST(KeyedRpHeap, DecreaseTakesTheKeyDirectly) {
+    record a{10, "a"}, b{20, "b"}, c{30, "c"};
+    keyed_rp_heap<record*, by_priority> heap;
+    heap.push(&a);
+    auto hb = heap.push(&b);
+    auto hc = heap.push(&c);
+    heap.pop();
+    // the cached key changes; the record itself is left alone
+    heap.decrease(hc, 5);
+    EXPECT_EQ(hc.key(), 5);
+    EXPECT_EQ(c.priority, 30);
+    EXPECT_EQ(heap.top(), &c);
+    // larger keys are ignored
+    heap.decrease(hb, 25);
+    EXPECT_EQ(hb.key(), 20);
+    EXPECT_EQ((*hb)->name, "b");
+    heap.erase(hc);
+    EXPECT_EQ(heap.top(), &b);
+    EXPECT_EQ(heap.size(), 1u);
+}
+
+// random decreases and erases against a sorted reference, with a custom key
+// order and pool_allocator; values are ids whose initial key is in a table
+TEST(KeyedRpHeap, RandomOperationsMatchReference) {
+    struct initial_key {
+        const std::vector<long>* table;
+        long operator()(int id) const { return (*table)[id]; }
+    };
+    typedef keyed_rp_heap<int, initial_key, std::greater<long>, pool_allocator<int>> heap_type;
+    std::mt19937 rng(11);
+    std::vector<long> key;
+    for (int i = 0; i < 3000; ++i)
+        key.push_back(static_cast<long>(rng() % 1000000));
+    heap_type heap(initial_key{&key});
+    std::vector<heap_type::const_iterator> handle;
+    std::vector<bool> alive(key.size(), true);
+    for (int i = 0; i < 3000; ++i)
+        handle.push_back(heap.push(i));
+    for (int step = 0; step < 3000; ++step) {
+        std::size_t i = rng() % handle.size();
+        if (!alive[i])
+            continue;
+        if (step % 3 == 0) {
+            heap.erase(handle[i]);
+            alive[i] = false;
+        } else {
+            // "decrease" under greater<> raises the key
+            key[i] += rng() % 1000;
+            heap.decrease(handle[i], key[i]);
+            ASSERT_EQ(handle[i].key(), key[i]);
+        }
+    }
+    std::vector<long> expected;
+    for (std::size_t i = 0; i < key.size(); ++i)
+        if (alive[i])
+            expected.push_back(key[i]);
+    std::sort(expected.begin(), expected.end(), std::greater<long>());
+    ASSERT_EQ(heap.size(), expected.size());
+    for (long k : expected) {
+        ASSERT_EQ(heap.top_key(), k);
+        int id;
+        heap.pop(id);
+        EXPECT_EQ(key[id], k);
+    }
+}
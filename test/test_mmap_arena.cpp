@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "rp_heap.h"
+#include "mmap_arena.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// small first region so the tests cross region boundaries quickly
+using SmallArena = mmap_arena_block_source<true, (std::size_t(1) << 20)>;
+using ArenaAlloc = pool_allocator<long long, 4096, SmallArena>;
+
+TEST(MmapArena, BlocksAreDistinctAndWritable) {
+    SmallArena arena;
+    std::vector<char*> blocks;
+    for (int i = 0; i < 2000; ++i) {
+        char* b = static_cast<char*>(arena.allocate(4096));
+        std::fill(b, b + 4096, static_cast<char>(i));
+        blocks.push_back(b);
+    }
+    for (int i = 0; i < 2000; ++i) {
+        EXPECT_EQ(blocks[i][0], static_cast<char>(i));
+        EXPECT_EQ(blocks[i][4095], static_cast<char>(i));
+    }
+    std::sort(blocks.begin(), blocks.end());
+    EXPECT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end());
+#if MMAP_ARENA_HAS_MMAP
+    // 2000 * 4 KiB needs several regions: 1 + 2 + 4 MiB
+    EXPECT_GE(arena.reserved_bytes(), std::size_t(2000) * 4096);
+#endif
+}
+
+TEST(MmapArena, DeallocatedBlocksAreReused) {
+    SmallArena arena;
+    void* a = arena.allocate(4096);
+    void* b = arena.allocate(4096);
+    static_assert(noexcept(arena.deallocate(a, 4096)), "trim() relies on it");
+    arena.deallocate(a, 4096);
+    EXPECT_EQ(arena.allocate(4096), a);
+    static_cast<char*>(a)[4095] = 1; // pages were released but stay mapped
+    EXPECT_NE(a, b);
+}
+
+TEST(MmapArena, PoolTrimReturnsBlocksToArena) {
+    ArenaAlloc pool;
+    std::vector<long long*> ptrs;
+    for (int i = 0; i < 100000; ++i) {
+        ptrs.push_back(pool.allocate(1));
+        *ptrs.back() = i;
+    }
+    for (int i = 0; i < 100000; ++i)
+        EXPECT_EQ(*ptrs[i], i);
+    pool_stats full = pool.stats();
+    std::size_t blocks = full.blocks;
+    for (long long* p : ptrs)
+        pool.deallocate(p, 1);
+    EXPECT_EQ(pool.trim(), full.bytes_reserved);
+    EXPECT_EQ(pool.stats().blocks, 0u);
+
+    // trimmed blocks are handed out again
+    for (int i = 0; i < 100000; ++i)
+        ptrs[i] = pool.allocate(1);
+    EXPECT_EQ(pool.stats().blocks, blocks);
+    for (long long* p : ptrs)
+        pool.deallocate(p, 1);
+}
+
+TEST(MmapArena, HeapWithArenaPool) {
+    rp_heap<int, std::less<int>, arena_pool_allocator<int>> h;
+    std::mt19937 rng(9);
+    std::vector<int> vals;
+    std::vector<decltype(h)::const_iterator> its;
+    for (int i = 0; i < 50000; ++i) {
+        vals.push_back(static_cast<int>(rng() % 1000000) + 1000);
+        its.push_back(h.push(vals.back()));
+    }
+    for (int i = 0; i < 50000; i += 7) {
+        vals[i] -= 1000;
+        h.decrease(its[i], vals[i]);
+    }
+    std::sort(vals.begin(), vals.end());
+    for (int v : vals) {
+        ASSERT_EQ(h.top(), v);
+        h.pop();
+    }
+    EXPECT_TRUE(h.empty());
+}
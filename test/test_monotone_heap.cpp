@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "monotone_heap.h"
+#include "pool_allocator.h"
+#include "sssp.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+TEST(MonotoneHeap, PopsInKeyOrder) {
+    monotone_heap<unsigned> h;
+    std::mt19937 rng(1);
+    std::vector<unsigned> vals;
+    for (int i = 0; i < 5000; ++i) {
+        vals.push_back(rng());
+        h.push(vals.back());
+    }
+    EXPECT_EQ(h.size(), 5000u);
+    std::sort(vals.begin(), vals.end());
+    for (unsigned v : vals) {
+        ASSERT_EQ(h.top(), v);
+        unsigned x;
+        h.pop(x);
+        EXPECT_EQ(x, v);
+        EXPECT_EQ(h.last_key(), v);
+    }
+    EXPECT_TRUE(h.empty());
+    EXPECT_THROW(h.pop(), std::runtime_error);
+}
+
+TEST(MonotoneHeap, RejectsKeysBelowLastPopped) {
+    monotone_heap<std::uint64_t> h;
+    h.push(10);
+    h.push(20);
+    h.pop();
+    EXPECT_THROW(h.push(5), std::invalid_argument);
+    auto it = h.push(15);
+    EXPECT_THROW(h.decrease(it, 3), std::invalid_argument);
+    h.decrease(it, 10);
+    EXPECT_EQ(h.top(), 10u);
+    h.push(10);
+    EXPECT_EQ(h.size(), 3u);
+}
+
+TEST(MonotoneHeap, TopDoesNotRaiseLastKey) {
+    monotone_heap<unsigned> h;
+    h.push(5);
+    EXPECT_EQ(h.top(), 5u);
+    EXPECT_EQ(h.last_key(), 0u);
+    h.push(3); // still above the last popped key
+    EXPECT_EQ(h.top(), 3u);
+    auto it = h.push(9);
+    EXPECT_EQ(h.top(), 3u);
+    h.decrease(it, 1);
+    EXPECT_EQ(h.top(), 1u);
+    unsigned x;
+    h.pop(x);
+    EXPECT_EQ(x, 1u);
+    EXPECT_EQ(h.last_key(), 1u);
+    h.pop(x);
+    EXPECT_EQ(x, 3u);
+    h.pop(x);
+    EXPECT_EQ(x, 5u);
+    EXPECT_TRUE(h.empty());
+}
+
+// interleaved push/pop/decrease against std::multiset, keys never below the
+// last popped key
+struct tagged {
+    std::uint32_t key;
+    std::size_t id;
+};
+
+struct tagged_key {
+    std::uint32_t operator()(const tagged& t) const { return t.key; }
+};
+
+TEST(MonotoneHeap, RandomOperationsMatchMultiset) {
+    typedef monotone_heap<tagged, tagged_key, pool_allocator<tagged>> heap_type;
+    heap_type h;
+    std::multiset<std::uint32_t> ref;
+    std::vector<heap_type::const_iterator> handle;
+    std::vector<std::size_t> live;  // ids still in the heap
+    std::vector<std::size_t> slot;  // position of each id in live
+    std::mt19937 rng(7);
+    std::uint32_t last = 0;
+    for (int step = 0; step < 50000; ++step) {
+        unsigned op = rng() % 3;
+        if (op == 0 || live.empty()) {
+            tagged t{last + static_cast<std::uint32_t>(rng() % 100000), handle.size()};
+            handle.push_back(h.push(t));
+            slot.push_back(live.size());
+            live.push_back(t.id);
+            ref.insert(t.key);
+        } else if (op == 1) {
+            std::size_t id = live[rng() % live.size()];
+            std::uint32_t old = handle[id]->key;
+            tagged t{last + (old - last) / 2, id};
+            if (t.key < old) {
+                ref.erase(ref.find(old));
+                ref.insert(t.key);
+            }
+            h.decrease(handle[id], t);
+        } else {
+            ASSERT_EQ(h.top().key, *ref.begin());
+            tagged t;
+            h.pop(t);
+            last = t.key;
+            ref.erase(ref.begin());
+            live[slot[t.id]] = live.back();
+            slot[live.back()] = slot[t.id];
+            live.pop_back();
+        }
+        ASSERT_EQ(h.size(), ref.size());
+        // top() between updates must not change what pop() returns
+        if (!ref.empty() && rng() % 4 == 0) {
+            ASSERT_EQ(h.top().key, *ref.begin());
+        }
+    }
+    h.clear();
+    EXPECT_TRUE(h.empty());
+}
+
+// the same Dijkstra code runs on either heap type
+template <class Heap>
+static std::vector<distance_type> run_dijkstra(const csr_graph& g, csr_graph::vertex_type s) {
+    std::vector<distance_type> dist(g.num_vertices(), unreachable);
+    std::vector<typename Heap::const_iterator> handle(g.num_vertices());
+    std::vector<char> state(g.num_vertices(), 0);
+    Heap heap(by_distance{dist.data()});
+    dist[s] = 0;
+    handle[s] = heap.push(s);
+    state[s] = 1;
+    while (!heap.empty()) {
+        csr_graph::vertex_type u;
+        heap.pop(u);
+        state[u] = 2;
+        for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            csr_graph::vertex_type v = g.targets[e];
+            distance_type nd = dist[u] + g.weights[e];
+            if (state[v] == 2 || nd >= dist[v])
+                continue;
+            dist[v] = nd;
+            if (state[v] == 1)
+                heap.decrease(handle[v], v);
+            else {
+                handle[v] = heap.push(v);
+                state[v] = 1;
+            }
+        }
+    }
+    return dist;
+}
+
+TEST(MonotoneHeap, DijkstraMatchesRpHeap) {
+    csr_graph g = make_random_graph(20000, 6, 1000, 3);
+    auto expected = dijkstra(g, 0);
+    EXPECT_EQ((run_dijkstra<monotone_heap<csr_graph::vertex_type, by_distance>>(g, 0)), expected);
+    EXPECT_EQ((run_dijkstra<rp_heap<csr_graph::vertex_type, by_distance>>(g, 0)), expected);
+    csr_graph road = make_road_graph(100, 100, 2);
+    EXPECT_EQ((run_dijkstra<monotone_heap<csr_graph::vertex_type, by_distance>>(road, 0)), dijkstra(road, 0));
+}
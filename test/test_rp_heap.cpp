@@ -1,10 +1,22 @@
 #include <gtest/gtest.h>
 #include "rp_heap.h"
+#include "pool_allocator.h"
 
 #include <algorithm>
 #include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <istream>
+#include <memory>
 #include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <streambuf>
+#include <tuple>
 #include <vector>
 
 // ---------- counting allocator for leak detection ----------
@@ -124,6 +136,424 @@ TEST(RpHeap, Clear) {
     EXPECT_EQ(h.size(), 0u);
 }
 
+TEST(RpHeap, ReserveAndShrinkToFit) {
+    rp_heap<int> h;
+    h.reserve(1000);
+    std::mt19937 rng(2024);
+    std::vector<int> vals;
+    for (int i = 0; i < 1000; ++i) {
+        int v = static_cast<int>(rng() % 5000);
+        vals.push_back(v);
+        h.push(v);
+    }
+    std::sort(vals.begin(), vals.end());
+
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(h.top(), vals[i]);
+        h.pop();
+    }
+    h.shrink_to_fit();
+    for (int i = 500; i < 1000; ++i) {
+        EXPECT_EQ(h.top(), vals[i]);
+        h.pop();
+    }
+    EXPECT_TRUE(h.empty());
+    h.shrink_to_fit();
+    h.push(7);
+    EXPECT_EQ(h.top(), 7);
+}
+
+TEST(RpHeap, PoolTrimReleasesEmptyBlocks) {
+    pool_allocator<long long> pool;
+    EXPECT_EQ(pool.stats().blocks, 0u);
+    std::vector<long long*> ptrs;
+    for (int i = 0; i < 10000; ++i)
+        ptrs.push_back(pool.allocate(1));
+    pool_stats full = pool.stats();
+    EXPECT_GT(full.blocks, 1u);
+    EXPECT_EQ(full.live_slots, 10000u);
+    EXPECT_EQ((full.live_slots + full.free_slots) % full.blocks, 0u);
+    EXPECT_GE(full.bytes_reserved, full.blocks * 4000);
+
+    // keep every 1000th slot alive: most blocks become empty
+    for (int i = 0; i < 10000; ++i)
+        if (i % 1000 != 0)
+            pool.deallocate(ptrs[i], 1);
+    EXPECT_EQ(pool.stats().live_slots, 10u);
+    EXPECT_EQ(pool.stats().blocks, full.blocks);
+
+    std::size_t released = pool.trim();
+    pool_stats trimmed = pool.stats();
+    EXPECT_GT(released, 0u);
+    EXPECT_LE(trimmed.blocks, 10u);
+    EXPECT_EQ(trimmed.live_slots, 10u);
+    EXPECT_EQ(full.bytes_reserved - trimmed.bytes_reserved, released);
+    EXPECT_EQ(pool.trim(), 0u);
+
+    // the surviving freelist still hands out usable slots
+    std::vector<long long*> more;
+    for (int i = 0; i < 5000; ++i) {
+        more.push_back(pool.allocate(1));
+        *more.back() = i;
+    }
+    for (int i = 0; i < 5000; ++i)
+        EXPECT_EQ(*more[i], i);
+    for (long long* p : more)
+        pool.deallocate(p, 1);
+    for (int i = 0; i < 10000; i += 1000)
+        pool.deallocate(ptrs[i], 1);
+    pool.trim();
+    EXPECT_EQ(pool.stats().blocks, 0u);
+    EXPECT_EQ(pool.stats().bytes_reserved, 0u);
+}
+
+TEST(RpHeap, PoolRecycleFreesEverySlotInPlace) {
+    pool_allocator<long long> pool;
+    for (int i = 0; i < 10000; ++i)
+        *pool.allocate(1) = i;
+    pool_stats full = pool.stats();
+    EXPECT_TRUE(pool.sole_owner());
+
+    pool.recycle();
+    pool_stats recycled = pool.stats();
+    EXPECT_EQ(recycled.blocks, full.blocks);
+    EXPECT_EQ(recycled.live_slots, 0u);
+    EXPECT_EQ(recycled.free_slots, full.live_slots + full.free_slots);
+
+    // refilling reuses the recycled blocks
+    std::vector<long long*> ptrs;
+    for (int i = 0; i < 10000; ++i) {
+        ptrs.push_back(pool.allocate(1));
+        *ptrs.back() = -i;
+    }
+    EXPECT_EQ(pool.stats().blocks, full.blocks);
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_EQ(*ptrs[i], -i);
+    std::sort(ptrs.begin(), ptrs.end());
+    EXPECT_EQ(std::adjacent_find(ptrs.begin(), ptrs.end()), ptrs.end());
+
+    // recycled blocks that were never refilled are released by trim()
+    pool.recycle();
+    pool.allocate(1);
+    EXPECT_EQ(pool.trim(), (full.blocks - 1) * (full.bytes_reserved / full.blocks));
+    EXPECT_EQ(pool.stats().blocks, 1u);
+
+    pool_allocator<long long> copy = pool;
+    EXPECT_FALSE(pool.sole_owner());
+}
+
+TEST(RpHeap, ClearRecyclesPoolAndHeapStaysUsable) {
+    rp_heap<int, std::less<int>, pool_allocator<int>> h;
+    std::mt19937 rng(8);
+    for (int round = 0; round < 3; ++round) {
+        std::vector<int> vals;
+        for (int i = 0; i < 20000; ++i) {
+            vals.push_back(static_cast<int>(rng() % 100000));
+            h.push(vals.back());
+        }
+        for (int i = 0; i < 100; ++i)
+            h.pop();
+        h.clear();
+        EXPECT_TRUE(h.empty());
+        for (int i = 0; i < 5000; ++i)
+            h.push(vals[i]);
+        std::sort(vals.begin(), vals.begin() + 5000);
+        for (int i = 0; i < 5000; ++i) {
+            ASSERT_EQ(h.top(), vals[i]);
+            h.pop();
+        }
+    }
+}
+
+TEST(RpHeap, ClearDestroysNonTrivialElements) {
+    auto by_value = [](const std::shared_ptr<int>& a, const std::shared_ptr<int>& b) { return *a < *b; };
+    typedef rp_heap<std::shared_ptr<int>, decltype(by_value), pool_allocator<std::shared_ptr<int>>> SharedHeap;
+    SharedHeap h(by_value);
+    std::vector<std::shared_ptr<int>> owned;
+    for (int i = 0; i < 3000; ++i) {
+        owned.push_back(std::make_shared<int>((i * 7919) % 3000));
+        h.push(owned.back());
+    }
+    // linked half trees, then cut subtrees, so the walk meets every shape
+    h.pop();
+    std::vector<SharedHeap::const_iterator> its;
+    for (int i = 0; i < 100; ++i)
+        its.push_back(h.push(std::make_shared<int>(5000 + i)));
+    h.pop();
+    for (int i = 0; i < 100; i += 2)
+        h.decrease(its[i], std::make_shared<int>(-i));
+    h.clear();
+    EXPECT_TRUE(h.empty());
+    for (const std::shared_ptr<int>& p : owned)
+        EXPECT_EQ(p.use_count(), 1);
+}
+
+TEST(RpHeap, PoolAutoTrimPastThreshold) {
+    pool_allocator<long long> pool;
+    pool.set_trim_threshold(2000);
+    std::vector<long long*> ptrs;
+    for (int i = 0; i < 100000; ++i)
+        ptrs.push_back(pool.allocate(1));
+    std::size_t peak = pool.stats().blocks;
+    for (long long* p : ptrs)
+        pool.deallocate(p, 1);
+    EXPECT_LT(pool.stats().blocks, peak / 10);
+    EXPECT_LE(pool.stats().free_slots, 4000u);
+}
+
+TEST(RpHeap, PoolDeallocateNeverThrows) {
+    // reached from ~rp_heap, so the auto-trim inside must not throw
+    pool_allocator<int> pool;
+    int* p = pool.allocate(1);
+    static_assert(noexcept(pool.deallocate(p, 1)), "pool_allocator::deallocate must be noexcept");
+    pool.deallocate(p, 1);
+}
+
+TEST(RpHeap, ShrinkToFitWithPoolKeepsHeapIntact) {
+    rp_heap<int, std::less<int>, pool_allocator<int>> h;
+    std::vector<int> vals;
+    std::mt19937 rng(5);
+    for (int i = 0; i < 20000; ++i) {
+        vals.push_back(static_cast<int>(rng() % 100000));
+        h.push(vals.back());
+    }
+    std::sort(vals.begin(), vals.end());
+    for (int i = 0; i < 19000; ++i)
+        h.pop();
+    h.shrink_to_fit();
+    for (int i = 19000; i < 20000; ++i) {
+        EXPECT_EQ(h.top(), vals[i]);
+        h.pop();
+    }
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(RpHeap, DefaultStatsAreZero) {
+    rp_heap<int> h;
+    for (int i = 100; i > 0; --i)
+        h.push(i);
+    h.pop();
+    rp_heap_stats st = h.stats();
+    EXPECT_EQ(st.comparisons, 0u);
+    EXPECT_EQ(st.links, 0u);
+    EXPECT_EQ(st.consolidations, 0u);
+}
+
+TEST(RpHeap, DisabledStatsTakeNoSpace) {
+    // the counters are the only difference: rp_heap_no_stats adds nothing
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats> CountedHeap;
+    EXPECT_EQ(sizeof(CountedHeap), sizeof(rp_heap<int>) + sizeof(rp_heap_counting_stats));
+}
+
+TEST(RpHeap, CountingStats) {
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats> CountedHeap;
+    CountedHeap h;
+    std::vector<CountedHeap::const_iterator> its;
+    for (int i = 0; i < 1024; ++i)
+        its.push_back(h.push(10000 + i));
+    // each push compares against the min
+    EXPECT_EQ(h.stats().comparisons, 1023u);
+    EXPECT_EQ(h.stats().links, 0u);
+
+    h.pop();
+    rp_heap_stats st = h.stats();
+    EXPECT_EQ(st.consolidations, 1u);
+    EXPECT_EQ(st.roots_scanned, 1023u);
+    EXPECT_EQ(st.max_roots, 1023u);
+    // 1023 singleton roots link down to one half tree per set bit of 1023
+    EXPECT_EQ(st.links, 1023u - 10u);
+    EXPECT_EQ(st.max_rank, 9);
+
+    // cutting deep nodes walks the rank-reduction loop
+    for (int i = 1023; i > 512; --i)
+        h.decrease(its[i], i - 2000);
+    EXPECT_GT(h.stats().rank_reduction_steps, 0u);
+
+    h.reset_stats();
+    EXPECT_EQ(h.stats().comparisons, 0u);
+    EXPECT_EQ(h.stats().max_rank, 0);
+    int prev = INT_MIN, x;
+    while (!h.empty()) {
+        h.pop(x);
+        EXPECT_LE(prev, x);
+        prev = x;
+    }
+}
+
+TEST(RpHeap, OnePassLinksEachRankOnce) {
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats, rp_heap_one_pass> OnePassHeap;
+    OnePassHeap h;
+    for (int i = 0; i < 1024; ++i)
+        h.push(10000 + i);
+    h.pop();
+    rp_heap_stats st = h.stats();
+    // 1023 singleton roots pair up once: 511 links of rank 1 and one
+    // singleton left over, against 1013 links under multipass
+    EXPECT_EQ(st.links, 511u);
+    EXPECT_EQ(st.max_rank, 1);
+    h.reset_stats();
+    h.pop();
+    EXPECT_EQ(h.stats().roots_scanned, 511u);
+    int prev = INT_MIN, x;
+    while (!h.empty()) {
+        h.pop(x);
+        EXPECT_LE(prev, x);
+        prev = x;
+    }
+}
+
+TEST(RpHeap, ChurnRanksStayWithinLogPhiBound) {
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats> CountedHeap;
+    const int N = 1 << 14;
+    CountedHeap h;
+    std::vector<CountedHeap::const_iterator> its;
+    std::mt19937 rng(3);
+    for (int i = 0; i < N; ++i)
+        its.push_back(h.push(static_cast<int>(rng() % (1 << 24))));
+    // erase-and-reinsert plus decreases cut half trees at a steady size,
+    // which drives ranks above log2(N)
+    for (int step = 0; step < 8 * N; ++step) {
+        size_t j = rng() % N;
+        int v = *its[j];
+        h.erase(its[j]);
+        its[j] = h.push(v + static_cast<int>(rng() % 1000));
+        size_t d = rng() % N;
+        h.decrease(its[d], *its[d] - static_cast<int>(rng() % 1000));
+        if (step % 64 == 0) {
+            h.push(INT_MIN);
+            h.pop();
+        }
+    }
+    // a half tree of rank r holds at least F(r + 2) nodes
+    long long fib = 1, fib_next = 2;
+    int bound = 0;
+    while (fib_next <= N + 1) {
+        ++bound;
+        long long sum = fib + fib_next;
+        fib = fib_next;
+        fib_next = sum;
+    }
+    EXPECT_GT(h.stats().max_rank, 14);
+    EXPECT_LE(h.stats().max_rank, bound);
+}
+
+// ---------- bulk construction ----------
+
+TEST(RpHeap, RangeConstructor) {
+    std::vector<int> vals = {9, 4, 7, 1, 8, 2, 6, 3, 5};
+    rp_heap<int> h(vals.begin(), vals.end());
+    EXPECT_EQ(h.size(), vals.size());
+    std::sort(vals.begin(), vals.end());
+    for (int v : vals) {
+        EXPECT_EQ(h.top(), v);
+        h.pop();
+    }
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(RpHeap, PushRangeIntoNonEmptyHeapWithHandles) {
+    rp_heap<int> h;
+    h.push(50);
+    h.push(60);
+    std::vector<int> vals = {70, 80, 55, 90};
+    std::vector<rp_heap<int>::const_iterator> its;
+    h.push_range(vals.begin(), vals.end(), std::back_inserter(its));
+    ASSERT_EQ(its.size(), vals.size());
+    EXPECT_EQ(h.size(), 6u);
+    EXPECT_EQ(h.top(), 50);
+    for (size_t i = 0; i < vals.size(); ++i)
+        EXPECT_EQ(*its[i], vals[i]);
+
+    h.decrease(its[3], 10);
+    EXPECT_EQ(h.top(), 10);
+    std::vector<int> result;
+    while (!h.empty()) {
+        result.push_back(h.top());
+        h.pop();
+    }
+    EXPECT_EQ(result, (std::vector<int>{10, 50, 55, 60, 70, 80}));
+}
+
+TEST(RpHeap, PushRangeNewMinAndEmptyRange) {
+    rp_heap<int> h;
+    h.push(5);
+    std::vector<int> none;
+    h.push_range(none.begin(), none.end());
+    EXPECT_EQ(h.size(), 1u);
+    std::vector<int> vals = {8, 3, 6};
+    h.push_range(vals.begin(), vals.end());
+    EXPECT_EQ(h.top(), 3);
+    EXPECT_EQ(h.size(), 4u);
+}
+
+// ---------- meld ----------
+
+TEST(RpHeap, MeldSplicesRootListsAndKeepsHandles) {
+    rp_heap<int> a, b;
+    std::vector<rp_heap<int>::const_iterator> its;
+    for (int i = 0; i < 100; ++i) {
+        its.push_back(a.push(2 * i + 10));
+        its.push_back(b.push(2 * i + 11));
+    }
+    // give both heaps internal structure before melding
+    a.pop();
+    b.pop();
+    its.erase(its.begin(), its.begin() + 2);
+
+    a.meld(b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(a.size(), 198u);
+    EXPECT_EQ(a.top(), 12);
+
+    // handles from both sides still work after the meld
+    a.decrease(its[1], 1);   // was 13, from b
+    a.decrease(its[10], 0);  // was 22, from a
+    std::vector<int> result;
+    while (!a.empty()) {
+        result.push_back(a.top());
+        a.pop();
+    }
+    ASSERT_EQ(result.size(), 198u);
+    EXPECT_EQ(result[0], 0);
+    EXPECT_EQ(result[1], 1);
+    EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
+}
+
+TEST(RpHeap, MeldWithEmptyHeaps) {
+    rp_heap<int> a, b;
+    a.meld(b);
+    EXPECT_TRUE(a.empty());
+    b.push(3);
+    a.meld(b);
+    EXPECT_EQ(a.size(), 1u);
+    EXPECT_EQ(a.top(), 3);
+    a.meld(b);
+    a.meld(a);
+    EXPECT_EQ(a.size(), 1u);
+}
+
+TEST(RpHeap, MeldWithUnequalAllocatorsTransfersValues) {
+    typedef rp_heap<int, std::less<int>, pool_allocator<int>> PoolHeap;
+    PoolHeap a, b;
+    for (int i = 0; i < 50; ++i) {
+        a.push(i * 3);
+        b.push(i * 3 + 1);
+    }
+    b.pop();
+    a.meld(b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(a.size(), 99u);
+    std::vector<int> result;
+    while (!a.empty()) {
+        result.push_back(a.top());
+        a.pop();
+    }
+    EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
+    // b is still usable after giving its nodes away
+    b.push(5);
+    EXPECT_EQ(b.top(), 5);
+}
+
 // ---------- decrease key ----------
 
 TEST(RpHeap, DecreaseKeyBasic) {
@@ -172,6 +602,227 @@ TEST(RpHeap, DecreaseKeyNonRootBecomesMin) {
     EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
 }
 
+// ---------- erase / update ----------
+
+TEST(RpHeap, EraseMinRootAndInnerNodes) {
+    rp_heap<int> h;
+    std::vector<rp_heap<int>::const_iterator> its;
+    for (int i = 0; i < 64; ++i)
+        its.push_back(h.push(i));
+    h.pop(); // builds half trees out of the 63 remaining roots
+    h.erase(its[1]);  // current min
+    h.erase(its[40]);
+    h.erase(its[63]);
+    h.erase(its[2]);
+    EXPECT_EQ(h.size(), 59u);
+    EXPECT_EQ(h.top(), 3);
+
+    std::vector<int> result;
+    while (!h.empty()) {
+        result.push_back(h.top());
+        h.pop();
+    }
+    std::vector<int> expected;
+    for (int i = 3; i < 63; ++i)
+        if (i != 40)
+            expected.push_back(i);
+    EXPECT_EQ(result, expected);
+}
+
+TEST(RpHeap, EraseOnlyElement) {
+    rp_heap<int> h;
+    auto it = h.push(1);
+    h.erase(it);
+    EXPECT_TRUE(h.empty());
+    h.push(2);
+    EXPECT_EQ(h.top(), 2);
+}
+
+TEST(RpHeap, UpdateIncreaseAndDecrease) {
+    rp_heap<int> h;
+    std::vector<rp_heap<int>::const_iterator> its;
+    for (int i = 0; i < 10; ++i)
+        its.push_back(h.push(i * 10));
+    h.pop(); // 0 leaves, the rest is linked
+
+    h.update(its[1], 95); // min grows past everything
+    EXPECT_EQ(h.top(), 20);
+    h.update(its[5], 5);  // plain decrease
+    EXPECT_EQ(h.top(), 5);
+    h.update(its[5], 55); // and back up again
+    EXPECT_EQ(h.top(), 20);
+    h.update(its[3], 30); // equal value is a no-op
+    EXPECT_EQ(*its[3], 30);
+
+    std::vector<int> result;
+    while (!h.empty()) {
+        result.push_back(h.top());
+        h.pop();
+    }
+    EXPECT_EQ(result, (std::vector<int>{20, 30, 40, 55, 60, 70, 80, 90, 95}));
+}
+
+template <class Heap>
+static void random_erase_update_matches_multiset() {
+    // value = key * N + id keeps values unique so handles map back to ids
+    const long long N = 5000;
+    Heap h;
+    std::multiset<long long> ref;
+    std::vector<typename Heap::const_iterator> its(N);
+    std::vector<bool> alive(N, false);
+    std::mt19937 rng(4242);
+
+    for (long long i = 0; i < N; ++i) {
+        long long v = static_cast<long long>(rng() % 100000) * N + i;
+        its[i] = h.push(v);
+        ref.insert(v);
+        alive[i] = true;
+    }
+    for (int round = 0; round < 20000 && !ref.empty(); ++round) {
+        long long id = rng() % N;
+        switch (rng() % 4) {
+        case 0:
+            if (alive[id]) {
+                ref.erase(ref.find(*its[id]));
+                h.erase(its[id]);
+                alive[id] = false;
+            }
+            break;
+        case 1:
+        case 2:
+            if (alive[id]) {
+                long long v = static_cast<long long>(rng() % 100000) * N + id;
+                ref.erase(ref.find(*its[id]));
+                h.update(its[id], v);
+                ref.insert(v);
+            }
+            break;
+        default: {
+            ASSERT_EQ(h.top(), *ref.begin());
+            alive[h.top() % N] = false;
+            ref.erase(ref.begin());
+            h.pop();
+        }
+        }
+        ASSERT_EQ(h.size(), ref.size());
+    }
+    while (!h.empty()) {
+        ASSERT_EQ(h.top(), *ref.begin());
+        ref.erase(ref.begin());
+        h.pop();
+    }
+    EXPECT_TRUE(ref.empty());
+}
+
+TEST(RpHeap, RandomEraseUpdateMatchesMultiset) {
+    random_erase_update_matches_multiset<rp_heap<long long>>();
+}
+
+TEST(RpHeap, OnePassRandomEraseUpdateMatchesMultiset) {
+    random_erase_update_matches_multiset<
+        rp_heap<long long, std::less<long long>, std::allocator<long long>, rp_heap_no_stats, rp_heap_one_pass>>();
+}
+
+// ---------- batch extraction ----------
+
+TEST(RpHeap, PopNExtractsSmallestInOrder) {
+    rp_heap<int> h;
+    std::mt19937 rng(99);
+    std::vector<int> vals;
+    for (int i = 0; i < 1000; ++i) {
+        int v = static_cast<int>(rng() % 100000);
+        vals.push_back(v);
+        h.push(v);
+    }
+    std::sort(vals.begin(), vals.end());
+
+    std::vector<int> out;
+    h.pop_n(100, std::back_inserter(out));
+    EXPECT_EQ(out, std::vector<int>(vals.begin(), vals.begin() + 100));
+    EXPECT_EQ(h.size(), 900u);
+    EXPECT_EQ(h.top(), vals[100]);
+
+    out.clear();
+    h.pop_n(5000, std::back_inserter(out)); // clamps to size()
+    EXPECT_EQ(out, std::vector<int>(vals.begin() + 100, vals.end()));
+    EXPECT_TRUE(h.empty());
+    h.pop_n(3, std::back_inserter(out));
+    EXPECT_EQ(out.size(), 900u);
+}
+
+TEST(RpHeap, PopNConsolidatesOnceForTheBatch) {
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats> CountedHeap;
+    std::mt19937 rng(21);
+    std::vector<int> vals(5000);
+    for (int& v : vals)
+        v = static_cast<int>(rng() % 1000000);
+    CountedHeap batch(vals.begin(), vals.end()), loop(vals.begin(), vals.end());
+    batch.pop();
+    loop.pop();
+    batch.reset_stats();
+    loop.reset_stats();
+
+    std::vector<int> from_batch, from_loop;
+    batch.pop_n(200, std::back_inserter(from_batch));
+    for (int i = 0, x; i < 200; ++i) {
+        loop.pop(x);
+        from_loop.push_back(x);
+    }
+    EXPECT_EQ(from_batch, from_loop);
+    EXPECT_EQ(batch.stats().consolidations, 1u);
+    EXPECT_EQ(loop.stats().consolidations, 200u);
+    EXPECT_LT(batch.stats().links, loop.stats().links);
+
+    // the rebuilt root list is a valid heap for every later operation
+    std::multiset<int> rest(vals.begin(), vals.end());
+    rest.erase(rest.begin());
+    for (int v : from_batch)
+        rest.erase(rest.find(v));
+    std::vector<CountedHeap::const_iterator> its;
+    for (int i = 0; i < 100; ++i) {
+        int v = static_cast<int>(rng() % 1000000);
+        its.push_back(batch.push(v));
+        rest.insert(v);
+    }
+    for (int i = 0; i < 100; i += 2) {
+        rest.erase(rest.find(*its[i]));
+        rest.insert(*its[i] - 500000);
+        batch.decrease(its[i], *its[i] - 500000);
+    }
+    ASSERT_EQ(batch.size(), rest.size());
+    for (int v : rest) {
+        ASSERT_EQ(batch.top(), v);
+        batch.pop();
+    }
+}
+
+TEST(RpHeap, PeekKDoesNotModifyHeap) {
+    rp_heap<int> h;
+    std::mt19937 rng(7);
+    std::vector<rp_heap<int>::const_iterator> its;
+    h.push(-1000000);
+    for (int i = 0; i < 2000; ++i)
+        its.push_back(h.push(static_cast<int>(rng() % 100000)));
+    // give the heap half trees, decreased nodes and a long root list
+    h.pop();
+    for (int i = 0; i < 2000; i += 7)
+        h.decrease(its[i], *its[i] - 50000);
+
+    std::vector<int> peeked;
+    h.peek_k(300, std::back_inserter(peeked));
+    ASSERT_EQ(peeked.size(), 300u);
+    EXPECT_TRUE(std::is_sorted(peeked.begin(), peeked.end()));
+
+    std::vector<int> popped;
+    h.pop_n(300, std::back_inserter(popped));
+    EXPECT_EQ(peeked, popped);
+
+    std::vector<int> all;
+    h.peek_k(h.size() + 10, std::back_inserter(all));
+    EXPECT_EQ(all.size(), h.size());
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end()));
+}
+
 // ---------- large random test ----------
 
 TEST(RpHeap, LargeRandomSortedOrder) {
@@ -222,6 +873,235 @@ TEST(RpHeap, MoveSemantics) {
     EXPECT_EQ(h.size(), 1u);
 }
 
+// ---------- in-place construction ----------
+
+// counts copies and moves; the constructor throws for priority < 0
+struct Tracked {
+    static int copies, moves;
+    int priority;
+    std::string tag;
+    Tracked(int p, const char* t) : priority(p), tag(t) {
+        if (p < 0)
+            throw std::invalid_argument("negative priority");
+    }
+    Tracked(const Tracked& o) : priority(o.priority), tag(o.tag) { ++copies; }
+    Tracked(Tracked&& o) : priority(o.priority), tag(std::move(o.tag)) { ++moves; }
+    Tracked& operator=(const Tracked& o) {
+        priority = o.priority;
+        tag = o.tag;
+        ++copies;
+        return *this;
+    }
+    Tracked& operator=(Tracked&& o) {
+        priority = o.priority;
+        tag = std::move(o.tag);
+        ++moves;
+        return *this;
+    }
+    bool operator<(const Tracked& o) const { return priority < o.priority; }
+};
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+TEST(RpHeap, EmplaceConstructsInPlace) {
+    rp_heap<Tracked> h;
+    Tracked::copies = Tracked::moves = 0;
+    auto a = h.emplace(5, "five");
+    auto b = h.emplace(3, "three");
+    h.emplace(8, "eight");
+    EXPECT_EQ(Tracked::copies, 0);
+    EXPECT_EQ(Tracked::moves, 0);
+    EXPECT_EQ(h.top().tag, "three");
+    EXPECT_EQ(a->tag, "five");
+    h.decrease(a, Tracked(1, "one"));
+    EXPECT_EQ(h.top().tag, "one");
+    h.erase(b);
+    EXPECT_EQ(h.size(), 2u);
+}
+
+TEST(RpHeap, EmplaceRangeFromArgumentTuples) {
+    rp_heap<Tracked> h;
+    h.emplace(4, "four");
+    std::vector<std::tuple<int, const char*>> args = {
+        std::make_tuple(7, "seven"), std::make_tuple(2, "two"), std::make_tuple(9, "nine")};
+    Tracked::copies = Tracked::moves = 0;
+    std::vector<rp_heap<Tracked>::const_iterator> handles;
+    h.emplace_range(args.begin(), args.end(), std::back_inserter(handles));
+    EXPECT_EQ(Tracked::copies, 0);
+    EXPECT_EQ(Tracked::moves, 0);
+    ASSERT_EQ(handles.size(), 3u);
+    EXPECT_EQ(handles[2]->tag, "nine");
+    EXPECT_EQ(h.size(), 4u);
+    EXPECT_EQ(h.top().tag, "two");
+    h.decrease(handles[2], Tracked(0, "zero"));
+    std::vector<int> order;
+    while (!h.empty()) {
+        order.push_back(h.top().priority);
+        h.pop();
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 2, 4, 7}));
+
+    rp_heap<std::pair<int, int>> pairs;
+    std::vector<std::tuple<int, int>> pair_args = {std::make_tuple(2, 0), std::make_tuple(1, 5)};
+    pairs.emplace_range(pair_args.begin(), pair_args.end());
+    EXPECT_EQ(pairs.top(), std::make_pair(1, 5));
+}
+
+// ---------- snapshots ----------
+
+TEST(RpHeap, SaveLoadRebuildsExactShape) {
+    typedef rp_heap<int, std::less<int>, std::allocator<int>, rp_heap_counting_stats> CountedHeap;
+    CountedHeap h;
+    std::vector<CountedHeap::const_iterator> its;
+    // a permutation of 0..4999, so the pops below remove exactly 0..999
+    for (int i = 0; i < 5000; ++i)
+        its.push_back(h.push((i * 7919) % 5000));
+    for (int i = 0; i < 1000; ++i)
+        h.pop();
+    // decreases leave cut subtrees and a long root list behind
+    for (int i = 0; i < 5000; i += 3)
+        if ((i * 7919) % 5000 >= 1000)
+            h.decrease(its[i], -i);
+    h.push(-1);
+
+    std::stringstream snapshot;
+    h.save(snapshot);
+    CountedHeap restored;
+    restored.push(12345); // replaced by load()
+    restored.reset_stats();
+    restored.load(snapshot);
+    EXPECT_EQ(restored.stats().comparisons, 0u);
+    EXPECT_EQ(restored.size(), h.size());
+    EXPECT_EQ(restored.top(), h.top());
+
+    // same shape: saving again gives the same bytes
+    std::stringstream again;
+    restored.save(again);
+    EXPECT_EQ(again.str(), snapshot.str());
+
+    while (!h.empty()) {
+        ASSERT_EQ(restored.top(), h.top());
+        h.pop();
+        restored.pop();
+    }
+    EXPECT_TRUE(restored.empty());
+}
+
+TEST(RpHeap, LoadReturnsHandlesInSnapshotOrder) {
+    rp_heap<int> h;
+    for (int i = 0; i < 100; ++i)
+        h.push((i * 37) % 101);
+    h.pop();
+    std::stringstream snapshot;
+    h.save(snapshot);
+
+    rp_heap<int> restored;
+    std::vector<rp_heap<int>::const_iterator> handles;
+    restored.load(snapshot, rp_heap_raw_codec<int>(), std::back_inserter(handles));
+    ASSERT_EQ(handles.size(), restored.size());
+    // the first handle is the min, and every element has one handle
+    EXPECT_EQ(*handles[0], restored.top());
+    std::vector<int> values;
+    for (auto it : handles)
+        values.push_back(*it);
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(std::unique(values.begin(), values.end()), values.end());
+    // handles work like the ones push() returns
+    auto target = std::find_if(handles.begin(), handles.end(), [](rp_heap<int>::const_iterator it) { return *it == 77; });
+    ASSERT_NE(target, handles.end());
+    restored.decrease(*target, -5);
+    EXPECT_EQ(restored.top(), -5);
+
+    rp_heap<int> empty, also_empty;
+    std::stringstream nothing;
+    empty.save(nothing);
+    also_empty.push(1);
+    also_empty.load(nothing);
+    EXPECT_TRUE(also_empty.empty());
+}
+
+struct StringCodec {
+    void write(std::ostream& out, const std::string& s) const {
+        std::uint32_t n = static_cast<std::uint32_t>(s.size());
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(s.data(), n);
+    }
+    std::string read(std::istream& in) const {
+        std::uint32_t n = 0;
+        in.read(reinterpret_cast<char*>(&n), sizeof(n));
+        std::string s(in ? n : 0, '\0');
+        in.read(&s[0], static_cast<std::streamsize>(s.size()));
+        return s;
+    }
+};
+
+TEST(RpHeap, SaveLoadWithCodec) {
+    rp_heap<std::string> h;
+    for (const char* word : {"pear", "apple", "fig", "kiwi", "banana", "cherry"})
+        h.push(word);
+    h.pop();
+    std::stringstream snapshot;
+    h.save(snapshot, StringCodec());
+    rp_heap<std::string> restored;
+    restored.load(snapshot, StringCodec());
+    std::vector<std::string> order;
+    while (!restored.empty()) {
+        order.push_back(restored.top());
+        restored.pop();
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"banana", "cherry", "fig", "kiwi", "pear"}));
+}
+
+TEST(RpHeap, LoadRejectsBadSnapshots) {
+    rp_heap<int> h;
+    for (int i = 0; i < 50; ++i)
+        h.push(i);
+    h.pop();
+    std::stringstream good;
+    h.save(good);
+    const std::string bytes = good.str();
+
+    rp_heap<int> restored;
+    std::istringstream garbage("not a heap at all, clearly");
+    EXPECT_THROW(restored.load(garbage), std::runtime_error);
+    std::string bad_version = bytes;
+    bad_version[4] = 9;
+    std::istringstream version(bad_version);
+    EXPECT_THROW(restored.load(version), std::runtime_error);
+    for (std::size_t cut : {bytes.size() - 1, bytes.size() / 2, std::size_t(25)}) {
+        std::istringstream truncated(bytes.substr(0, cut));
+        restored.push(1);
+        EXPECT_THROW(restored.load(truncated), std::runtime_error);
+        EXPECT_TRUE(restored.empty());
+    }
+}
+
+// a stream buffer that cannot seek, so load() cannot measure what is left
+struct ForwardOnlyBuf : std::streambuf {
+    explicit ForwardOnlyBuf(std::string& bytes) { setg(&bytes[0], &bytes[0], &bytes[0] + bytes.size()); }
+};
+
+TEST(RpHeap, LoadDoesNotTrustHeaderSize) {
+    rp_heap<int> h;
+    for (int i = 0; i < 50; ++i)
+        h.push(i);
+    std::stringstream good;
+    h.save(good);
+    // claim 2^50 elements; reserving them up front would exhaust memory
+    std::string bytes = good.str();
+    const std::uint64_t huge = std::uint64_t(1) << 50;
+    std::memcpy(&bytes[8], &huge, sizeof(huge));
+
+    typedef rp_heap<int, std::less<int>, pool_allocator<int>> PoolHeap;
+    PoolHeap restored;
+    std::istringstream seekable(bytes);
+    EXPECT_THROW(restored.load(seekable), std::runtime_error);
+    ForwardOnlyBuf buf(bytes);
+    std::istream forward_only(&buf);
+    EXPECT_THROW(restored.load(forward_only), std::runtime_error);
+    EXPECT_TRUE(restored.empty());
+}
+
 // ---------- memory leak tests ----------
 
 TEST(RpHeapMemory, DestructorFreesAll) {
@@ -299,6 +1179,67 @@ TEST(RpHeapMemory, DecreaseKeyNoLeak) {
     EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
 }
 
+TEST(RpHeapMemory, PushRangeNoLeak) {
+    reset_counters();
+    {
+        std::vector<int> vals(1000);
+        for (int i = 0; i < 1000; ++i)
+            vals[i] = (i * 7919) % 1000;
+        rp_heap<int, std::less<int>, CountingAllocator<int>> h(vals.begin(), vals.end());
+        for (int i = 0; i < 400; ++i)
+            h.pop();
+    }
+    EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+    EXPECT_EQ(g_alloc_count.load(), 1000);
+}
+
+TEST(RpHeapMemory, ThrowingEmplaceNoLeak) {
+    reset_counters();
+    {
+        rp_heap<Tracked, std::less<Tracked>, CountingAllocator<Tracked>> h;
+        h.emplace(1, "one");
+        EXPECT_THROW(h.emplace(-1, "bad"), std::invalid_argument);
+        std::vector<std::tuple<int, const char*>> args = {
+            std::make_tuple(3, "three"), std::make_tuple(-2, "bad"), std::make_tuple(4, "four")};
+        EXPECT_THROW(h.emplace_range(args.begin(), args.end()), std::invalid_argument);
+        // the elements built before the throw stay in the heap
+        EXPECT_EQ(h.size(), 2u);
+        EXPECT_EQ(h.top().priority, 1);
+    }
+    EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+}
+
+TEST(RpHeapMemory, MeldNoLeak) {
+    reset_counters();
+    {
+        rp_heap<int, std::less<int>, CountingAllocator<int>> a, b;
+        for (int i = 0; i < 100; ++i) {
+            a.push(i);
+            b.push(i);
+        }
+        a.meld(b);
+        for (int i = 0; i < 50; ++i)
+            a.pop();
+    }
+    EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+}
+
+TEST(RpHeapMemory, EraseNoLeak) {
+    reset_counters();
+    {
+        rp_heap<int, std::less<int>, CountingAllocator<int>> h;
+        std::vector<decltype(h.push(0))> iters;
+        for (int i = 0; i < 100; ++i)
+            iters.push_back(h.push(i));
+        h.pop();
+        for (int i = 1; i < 100; i += 2)
+            h.erase(iters[i]);
+        EXPECT_EQ(h.size(), 49u);
+        EXPECT_EQ(g_alloc_count.load() - g_dealloc_count.load(), 49);
+    }
+    EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+}
+
 TEST(RpHeapMemory, LargeRandomNoLeak) {
     reset_counters();
     {
@@ -312,3 +1253,26 @@ TEST(RpHeapMemory, LargeRandomNoLeak) {
     }
     EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
 }
+
+TEST(RpHeapMemory, TruncatedLoadNoLeak) {
+    reset_counters();
+    {
+        rp_heap<int> h;
+        for (int i = 0; i < 1000; ++i)
+            h.push((i * 7919) % 1000);
+        for (int i = 0; i < 10; ++i)
+            h.pop();
+        std::stringstream snapshot;
+        h.save(snapshot);
+        const std::string bytes = snapshot.str();
+
+        rp_heap<int, std::less<int>, CountingAllocator<int>> restored;
+        std::istringstream truncated(bytes.substr(0, bytes.size() * 2 / 3));
+        EXPECT_THROW(restored.load(truncated), std::runtime_error);
+        EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+        std::istringstream whole(bytes);
+        restored.load(whole);
+        EXPECT_EQ(restored.size(), 990u);
+    }
+    EXPECT_EQ(g_alloc_count.load(), g_dealloc_count.load());
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "sssp.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// reference distances by Bellman-Ford
+static std::vector<distance_type> bellman_ford(const csr_graph& g, csr_graph::vertex_type s) {
+    std::vector<distance_type> dist(g.num_vertices(), unreachable);
+    dist[s] = 0;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (csr_graph::vertex_type u = 0; u < g.num_vertices(); ++u) {
+            if (dist[u] == unreachable)
+                continue;
+            for (std::size_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                distance_type nd = dist[u] + g.weights[e];
+                if (nd < dist[g.targets[e]]) {
+                    dist[g.targets[e]] = nd;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return dist;
+}
+
+// ---------- csr_graph ----------
+
+TEST(CsrGraph, FromEdgesGroupsBySource) {
+    std::vector<csr_graph::edge> edges = {{2, 0, 5}, {0, 1, 1}, {0, 2, 4}, {1, 2, 2}};
+    csr_graph g = csr_graph::from_edges(3, edges);
+    EXPECT_EQ(g.num_vertices(), 3u);
+    EXPECT_EQ(g.num_edges(), 4u);
+    EXPECT_EQ(g.offsets, (std::vector<std::size_t>{0, 2, 3, 4}));
+    EXPECT_EQ(g.targets, (std::vector<csr_graph::vertex_type>{1, 2, 2, 0}));
+    EXPECT_EQ(g.weights, (std::vector<csr_graph::weight_type>{1, 4, 2, 5}));
+    EXPECT_THROW(csr_graph::from_edges(2, edges), std::out_of_range);
+}
+
+// ---------- dijkstra ----------
+
+TEST(CsrGraph, DimacsRoundTrip) {
+    std::istringstream in(
+        "c tiny road network\n"
+        "p sp 4 5\n"
+        "c arcs\n"
+        "a 1 2 7\n"
+        "a 1 3 2\n"
+        "a 3 2 3\n"
+        "a 2 4 1\n"
+        "\n"
+        "  \t\n"
+        "a 4 1 10\n");
+    csr_graph g = load_dimacs_gr(in);
+    EXPECT_EQ(g.num_vertices(), 4u);
+    EXPECT_EQ(g.num_edges(), 5u);
+    std::vector<distance_type> d = dijkstra(g, 0);
+    EXPECT_EQ(d, (std::vector<distance_type>{0, 5, 2, 6}));
+
+    std::ostringstream out;
+    write_dimacs_gr(out, g);
+    std::istringstream again(out.str());
+    csr_graph h = load_dimacs_gr(again);
+    EXPECT_EQ(h.offsets, g.offsets);
+    EXPECT_EQ(h.targets, g.targets);
+    EXPECT_EQ(h.weights, g.weights);
+}
+
+TEST(CsrGraph, DimacsRejectsMalformedInput) {
+    std::istringstream no_problem("a 1 2 3\n");
+    EXPECT_THROW(load_dimacs_gr(no_problem), std::runtime_error);
+    std::istringstream out_of_range("p sp 2 1\na 1 3 5\n");
+    EXPECT_THROW(load_dimacs_gr(out_of_range), std::runtime_error);
+    std::istringstream garbage("p sp 2 1\nx\n");
+    EXPECT_THROW(load_dimacs_gr(garbage), std::runtime_error);
+}
+
+TEST(CsrGraph, RoadGraphIsSparseAndSymmetric) {
+    csr_graph g = make_road_graph(64, 64, 3);
+    EXPECT_EQ(g.num_vertices(), 64u * 64u);
+    EXPECT_LT(g.num_edges(), 4u * g.num_vertices());
+    EXPECT_EQ(g.num_edges() % 2, 0u);
+    std::vector<distance_type> d = dijkstra(g, 0);
+    std::size_t reached = std::count_if(d.begin(), d.end(), [](distance_type x) { return x != unreachable; });
+    EXPECT_GT(reached, g.num_vertices() * 9 / 10);
+}
+
+TEST(Sssp, DijkstraSmallGraph) {
+    std::vector<csr_graph::edge> edges = {
+        {0, 1, 7}, {0, 2, 9}, {0, 5, 14}, {1, 2, 10}, {1, 3, 15},
+        {2, 3, 11}, {2, 5, 2}, {3, 4, 6}, {5, 4, 9}};
+    csr_graph g = csr_graph::from_edges(7, edges);
+    sssp_stats stats;
+    auto dist = dijkstra(g, 0, &stats);
+    EXPECT_EQ(dist, (std::vector<distance_type>{0, 7, 9, 20, 20, 11, unreachable}));
+    EXPECT_EQ(stats.pops, 6u);
+    EXPECT_GT(stats.decreases, 0u);
+}
+
+TEST(Sssp, DijkstraMatchesBellmanFord) {
+    csr_graph g = make_random_graph(2000, 5, 100, 11);
+    EXPECT_EQ(dijkstra(g, 0), bellman_ford(g, 0));
+}
+
+// ---------- delta-stepping ----------
+
+TEST(Sssp, DeltaSteppingMatchesDijkstraOnRandomGraph) {
+    csr_graph g = make_random_graph(5000, 6, 1000, 3);
+    auto expected = dijkstra(g, 17);
+    for (unsigned threads : {1u, 2u, 4u})
+        for (csr_graph::weight_type delta : {1u, 50u, 400u, 5000u})
+            EXPECT_EQ(delta_stepping(g, 17, delta, threads), expected)
+                << "threads " << threads << " delta " << delta;
+}
+
+TEST(Sssp, DeltaSteppingMatchesDijkstraOnGrid) {
+    csr_graph g = make_grid_graph(80, 60, 20, 5);
+    auto expected = dijkstra(g, 0);
+    for (unsigned threads : {1u, 3u})
+        EXPECT_EQ(delta_stepping(g, 0, 10, threads), expected) << "threads " << threads;
+}
+
+TEST(Sssp, DeltaSteppingUnreachableAndSingleVertex) {
+    csr_graph g = csr_graph::from_edges(4, {{0, 1, 3}, {2, 3, 1}});
+    auto dist = delta_stepping(g, 0, 2, 2);
+    EXPECT_EQ(dist, (std::vector<distance_type>{0, 3, unreachable, unreachable}));
+    csr_graph single = csr_graph::from_edges(1, {});
+    EXPECT_EQ(delta_stepping(single, 0, 1, 4), std::vector<distance_type>{0});
+}
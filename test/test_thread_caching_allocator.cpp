@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "rp_heap.h"
+#include "thread_caching_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+using TcAlloc = thread_caching_allocator<long long>;
+using TcHeap = rp_heap<int, std::less<int>, thread_caching_allocator<int>>;
+
+// ---------- single thread ----------
+
+TEST(ThreadCachingAllocator, DistinctAlignedSlots) {
+    TcAlloc a;
+    std::set<long long*> seen;
+    std::vector<long long*> ptrs;
+    for (int i = 0; i < 5000; ++i) {
+        long long* p = a.allocate(1);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignof(long long), 0u);
+        EXPECT_TRUE(seen.insert(p).second);
+        *p = i;
+        ptrs.push_back(p);
+    }
+    for (int i = 0; i < 5000; ++i)
+        EXPECT_EQ(*ptrs[i], i);
+    for (long long* p : ptrs)
+        a.deallocate(p, 1);
+}
+
+TEST(ThreadCachingAllocator, LocalFreeIsReusedFirst) {
+    TcAlloc a;
+    long long* p = a.allocate(1);
+    a.deallocate(p, 1);
+    EXPECT_EQ(a.allocate(1), p);
+    a.deallocate(p, 1);
+}
+
+TEST(ThreadCachingAllocator, InstancesCompareEqual) {
+    TcAlloc a, b;
+    thread_caching_allocator<int> c(a);
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(a != b);
+    EXPECT_TRUE(thread_caching_allocator<int>() == c);
+}
+
+TEST(ThreadCachingAllocator, ArrayAllocationFallsBack) {
+    TcAlloc a;
+    long long* p = a.allocate(100);
+    for (int i = 0; i < 100; ++i)
+        p[i] = i;
+    EXPECT_EQ(p[99], 99);
+    a.deallocate(p, 100);
+}
+
+TEST(ThreadCachingAllocator, HeapSortsAndMelds) {
+    TcHeap a, b;
+    std::vector<int> vals;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 2000; ++i) {
+        int v = static_cast<int>(rng() % 100000);
+        vals.push_back(v);
+        (i % 2 ? a : b).push(v);
+    }
+    a.meld(b);
+    EXPECT_TRUE(b.empty());
+    std::sort(vals.begin(), vals.end());
+    for (int v : vals) {
+        int x;
+        a.pop(x);
+        EXPECT_EQ(x, v);
+    }
+}
+
+// ---------- cross-thread frees ----------
+
+// Slots freed by another thread go to the owner's return stack and come back
+// to the owner once its local freelist is exhausted.
+TEST(ThreadCachingAllocator, RemoteFreesAreReclaimedByOwner) {
+    TcAlloc a;
+    std::vector<long long*> local;
+    std::set<long long*> freed_remotely;
+    std::vector<long long*> batch;
+    for (int i = 0; i < 1000; ++i)
+        batch.push_back(a.allocate(1));
+    freed_remotely.insert(batch.begin(), batch.end());
+    std::thread([&] {
+        TcAlloc b;
+        for (long long* p : batch)
+            b.deallocate(p, 1);
+    }).join();
+
+    // keep allocating until every remotely freed slot has come back
+    int reclaimed = 0;
+    for (int i = 0; i < 100000 && reclaimed < 1000; ++i) {
+        long long* p = a.allocate(1);
+        local.push_back(p);
+        reclaimed += static_cast<int>(freed_remotely.count(p));
+    }
+    EXPECT_EQ(reclaimed, 1000);
+    for (long long* p : local)
+        a.deallocate(p, 1);
+}
+
+// Producer threads push into heaps that a consumer thread drains, so nearly
+// every node is freed on a thread other than the one that allocated it.
+TEST(ThreadCachingAllocator, ProducerConsumerHeaps) {
+    const int kProducers = 3, kHeaps = 60, kPerHeap = 500;
+    std::mutex m;
+    std::vector<TcHeap*> ready;
+    std::atomic<int> done{0};
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kProducers; ++t) {
+        producers.emplace_back([&, t] {
+            std::mt19937 rng(t + 1);
+            for (int h = 0; h < kHeaps / kProducers; ++h) {
+                TcHeap* heap = new TcHeap;
+                for (int i = 0; i < kPerHeap; ++i)
+                    heap->push(static_cast<int>(rng() % 100000));
+                std::lock_guard<std::mutex> lock(m);
+                ready.push_back(heap);
+            }
+            done++;
+        });
+    }
+
+    long long popped = 0;
+    bool sorted = true;
+    std::thread consumer([&] {
+        for (;;) {
+            TcHeap* heap = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (!ready.empty()) {
+                    heap = ready.back();
+                    ready.pop_back();
+                }
+            }
+            if (!heap) {
+                if (done == kProducers) {
+                    std::lock_guard<std::mutex> lock(m);
+                    if (ready.empty())
+                        return;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            int prev = -1, x;
+            while (!heap->empty()) {
+                heap->pop(x);
+                sorted = sorted && prev <= x;
+                prev = x;
+                popped++;
+            }
+            delete heap;
+        }
+    });
+
+    for (std::thread& p : producers)
+        p.join();
+    consumer.join();
+    EXPECT_TRUE(sorted);
+    EXPECT_EQ(popped, static_cast<long long>(kHeaps) * kPerHeap);
+}
+
+// A cache left behind by an exited thread is adopted by the next thread, so
+// nodes it allocated can still be freed and its slots reused.
+TEST(ThreadCachingAllocator, ExitedThreadCacheIsAdopted) {
+    std::vector<long long*> ptrs;
+    std::thread([&] {
+        TcAlloc a;
+        for (int i = 0; i < 100; ++i) {
+            ptrs.push_back(a.allocate(1));
+            *ptrs.back() = i;
+        }
+    }).join();
+
+    TcAlloc a;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(*ptrs[i], i);
+        a.deallocate(ptrs[i], 1);
+    }
+    std::thread([&] {
+        TcAlloc b;
+        for (int i = 0; i < 100; ++i)
+            b.deallocate(b.allocate(1), 1);
+    }).join();
+}
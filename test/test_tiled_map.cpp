@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "tiled_map.h"
+#include "astar_batch.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::string temp_path(const char* name) {
+    return ::testing::TempDir() + name;
+}
+
+TEST(TiledMap, InMemoryGridMatchesMap) {
+    // sizes that are not multiples of the 8 x 8 tile
+    grid_map map = make_random_map(37, 21, 0.4, 3);
+    TiledGrid grid(map, 37, 21);
+    EXPECT_FALSE(grid.mapped());
+    EXPECT_EQ(grid.width(), 37);
+    EXPECT_EQ(grid.height(), 21);
+    EXPECT_EQ(grid.cells(), 37u * 21u);
+    EXPECT_EQ(grid.data_bytes(), 5u * 3u * 8u);
+    for (int y = 0; y < 21; ++y)
+        for (int x = 0; x < 37; ++x)
+            EXPECT_EQ(grid.blocked(x, y), map[y][x] != 0) << x << ", " << y;
+}
+
+TEST(TiledMap, FileRoundTripIsMapped) {
+    grid_map map = make_random_map(300, 70, 0.3, 4);
+    const std::string path = temp_path("round_trip.tmap");
+    ASSERT_TRUE(write_tiled_map(path, map, 300, 70));
+    {
+        TiledGrid grid(path);
+        EXPECT_EQ(grid.mapped(), TILED_MAP_HAS_MMAP != 0);
+        EXPECT_EQ(grid.width(), 300);
+        EXPECT_EQ(grid.height(), 70);
+        for (int y = 0; y < 70; ++y)
+            for (int x = 0; x < 300; ++x)
+                ASSERT_EQ(grid.blocked(x, y), map[y][x] != 0) << x << ", " << y;
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TiledMap, RejectsBadFiles) {
+    const std::string path = temp_path("bad.tmap");
+    EXPECT_THROW(TiledGrid(temp_path("missing.tmap")), std::runtime_error);
+
+    grid_map map = make_random_map(16, 16, 0.3, 5);
+    std::ostringstream good;
+    write_tiled_map(good, TiledGrid(map, 16, 16));
+    const std::string bytes = good.str();
+    auto write = [&](const std::string& contents) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    };
+
+    write(bytes.substr(0, 10));
+    EXPECT_THROW(TiledGrid{path}, std::runtime_error);
+    std::string bad_magic = bytes;
+    bad_magic[0] = 'X';
+    write(bad_magic);
+    EXPECT_THROW(TiledGrid{path}, std::runtime_error);
+    std::string bad_version = bytes;
+    bad_version[offsetof(tiled_map_header, version)] = 9;
+    write(bad_version);
+    EXPECT_THROW(TiledGrid{path}, std::runtime_error);
+    write(bytes.substr(0, bytes.size() - 8));
+    EXPECT_THROW(TiledGrid{path}, std::runtime_error);
+    // a well-formed header of 2^32 cells whose tiles are missing
+    tiled_map_header huge;
+    std::memcpy(&huge, bytes.data(), sizeof(huge));
+    huge.width = huge.height = 65536;
+    huge.tiles_x = huge.tiles_y = 8192;
+    huge.data_bytes = std::uint64_t(8192) * 8192 * 8;
+    write(std::string(reinterpret_cast<const char*>(&huge), sizeof(huge)));
+    EXPECT_THROW(TiledGrid{path}, std::runtime_error);
+    write(bytes);
+    EXPECT_NO_THROW(TiledGrid{path});
+    std::remove(path.c_str());
+}
+
+// reports 2^32 cells without storing any
+struct HugeGrid {
+    int width() const { return 65536; }
+    int height() const { return 65536; }
+    std::size_t cells() const { return std::size_t(65536) * 65536; }
+    bool blocked(int, int) const { return false; }
+};
+
+TEST(TiledMap, EngineSearchesMoreThanIntMaxCells) {
+    BasicGridAStar<HugeGrid> engine(std::make_shared<const HugeGrid>());
+    const std::size_t directory = engine.state_bytes();
+    EXPECT_LT(directory, std::size_t(64) << 20); // one pointer per 32 x 32 block
+    std::vector<Node> path;
+    astar_stats stats;
+    // across the corner where y * width + x passes INT_MAX
+    ASSERT_TRUE(engine.search(65500, 65500, 65535, 65535, path, &stats));
+    EXPECT_EQ(path.size(), 36u);
+    EXPECT_EQ(path.back().x, 65535);
+    EXPECT_EQ(path.back().y, 65535);
+    EXPECT_NEAR(stats.cost, 35 * std::sqrt(2.0), 1e-9);
+    ASSERT_TRUE(engine.search(0, 0, 3, 4, path));
+    // only the blocks around the two queries were committed
+    EXPECT_LT(engine.state_bytes() - directory, std::size_t(8) << 20);
+}
+
+#if TILED_MAP_HAS_MMAP
+TEST(TiledMap, MapsAndSearchesMoreThanIntMaxCells) {
+    // a sparse file: the header, then 512 MiB of zero (passable) tiles
+    grid_map map = make_random_map(16, 16, 0.3, 5);
+    std::ostringstream small;
+    write_tiled_map(small, TiledGrid(map, 16, 16));
+    tiled_map_header huge;
+    std::memcpy(&huge, small.str().data(), sizeof(huge));
+    huge.width = huge.height = 65536;
+    huge.tiles_x = huge.tiles_y = 8192;
+    huge.data_bytes = std::uint64_t(8192) * 8192 * 8;
+    const std::string path = temp_path("huge.tmap");
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    ASSERT_EQ(::truncate(path.c_str(), static_cast<off_t>(huge.data_offset + huge.data_bytes)), 0);
+    {
+        auto grid = std::make_shared<const TiledGrid>(path);
+        EXPECT_EQ(grid->cells(), std::size_t(65536) * 65536);
+        TiledGridAStar engine(grid);
+        std::vector<Node> path_found;
+        ASSERT_TRUE(engine.search(65535, 65535, 65530, 65000, path_found));
+        EXPECT_EQ(path_found.size(), 536u);
+    }
+    std::remove(path.c_str());
+}
+#endif
+
+TEST(TiledMap, EngineOnMappedGridMatchesFlatGrid) {
+    grid_map map = make_random_map(90, 50, 0.3, 6);
+    std::vector<scenario> queries = generate_scenarios(map, 90, 50, 200, 4);
+    const std::string path = temp_path("engine.tmap");
+    ASSERT_TRUE(write_tiled_map(path, map, 90, 50));
+    {
+        GridAStar flat(map, 90, 50);
+        TiledGridAStar tiled(std::make_shared<const TiledGrid>(path));
+        std::vector<Node> expected, path_found;
+        for (const scenario& sc : queries) {
+            astar_stats expected_stats, stats;
+            flat.search(sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, expected, &expected_stats);
+            ASSERT_TRUE(tiled.search(sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, path_found, &stats));
+            ASSERT_EQ(path_found.size(), expected.size());
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                EXPECT_EQ(path_found[i].x, expected[i].x);
+                EXPECT_EQ(path_found[i].y, expected[i].y);
+            }
+            EXPECT_EQ(stats.cost, expected_stats.cost);
+            EXPECT_EQ(stats.expansions, expected_stats.expansions);
+        }
+
+        // a pool of engines over the one mapping
+        BasicBatchAStar<TiledGrid> batch(tiled.map(), 3);
+        std::vector<path_query> batch_queries;
+        for (const scenario& sc : queries)
+            batch_queries.emplace_back(Node(sc.start_x, sc.start_y), Node(sc.goal_x, sc.goal_y));
+        std::vector<path_result> results = batch.run(batch_queries);
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            astar_stats stats;
+            flat.search(queries[i].start_x, queries[i].start_y, queries[i].goal_x, queries[i].goal_y, expected, &stats);
+            EXPECT_EQ(results[i].path.size(), expected.size());
+            EXPECT_EQ(results[i].stats.cost, stats.cost);
+        }
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,249 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 James Yip
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef THREAD_CACHING_ALLOCATOR_H_
+#define THREAD_CACHING_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// Thread-caching pool allocator that tolerates cross-thread frees.
+///
+/// Like pool_allocator, objects are carved out of fixed-size blocks and
+/// recycled through an intrusive freelist, but the pool is shared by every
+/// instance for the same T and BlockSize, and each thread allocates from its
+/// own cache without locking. Every block records the cache that carved it.
+/// A slot freed by its owning thread goes straight back on the local
+/// freelist. A slot freed by any other thread is pushed onto the owner's
+/// lock-free return stack. The owner takes that whole stack in one atomic
+/// exchange when its local freelist runs dry.
+///
+/// When a thread exits, its cache (and whatever is still on its freelists)
+/// is handed to the next thread that starts allocating. Memory is returned to
+/// the system only at process exit; the pool is deliberately leaked so nodes
+/// freed during static destruction remain valid.
+///
+/// Template parameters:
+///   T         - element type
+///   BlockSize - size of each block in bytes, a power of two (default 4096);
+///               blocks are aligned to it so a slot finds its block header
+///               by masking its address
+template <class T, std::size_t BlockSize = 4096>
+class thread_caching_allocator
+{
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
+public:
+    using value_type    = T;
+    using pointer       = T*;
+    using const_pointer = const T*;
+    using reference     = T&;
+    using const_reference = const T&;
+    using size_type     = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    template <class U>
+    struct rebind { using other = thread_caching_allocator<U, BlockSize>; };
+
+private:
+    static constexpr std::size_t slot_align =
+        alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+
+    static constexpr std::size_t raw_slot =
+        sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*);
+
+    static constexpr std::size_t slot_size =
+        ((raw_slot + slot_align - 1) / slot_align) * slot_align;
+
+    struct ThreadCache;
+
+    // Header at the start of each block: the cache that owns its slots.
+    static constexpr std::size_t header_size =
+        ((sizeof(ThreadCache*) + slot_align - 1) / slot_align) * slot_align;
+
+    static constexpr std::size_t slots_per_block =
+        (BlockSize - header_size) / slot_size;
+
+    static_assert(slots_per_block > 0, "BlockSize too small for T");
+
+    // Blocks are carved from chunks of this many blocks; one extra block is
+    // allocated per chunk to align the rest.
+    static constexpr std::size_t blocks_per_chunk = 16;
+
+    struct ThreadCache
+    {
+        char* free_list = nullptr;              // touched by the owner only
+        std::atomic<char*> remote_free{nullptr}; // pushed to by other threads
+        char* chunk_next = nullptr;              // next uncarved block
+        char* chunk_end  = nullptr;
+
+        void refill()
+        {
+            // take every slot other threads have returned in one exchange
+            free_list = remote_free.exchange(nullptr, std::memory_order_acquire);
+            if (free_list)
+                return;
+            if (chunk_next == chunk_end)
+            {
+                std::size_t bytes = (blocks_per_chunk + 1) * BlockSize;
+                char* raw = static_cast<char*>(::operator new(bytes));
+                std::uintptr_t aligned =
+                    (reinterpret_cast<std::uintptr_t>(raw) + BlockSize - 1) & ~(std::uintptr_t)(BlockSize - 1);
+                chunk_next = reinterpret_cast<char*>(aligned);
+                chunk_end = chunk_next + blocks_per_chunk * BlockSize;
+            }
+            char* block = chunk_next;
+            chunk_next += BlockSize;
+            ThreadCache* self = this;
+            std::memcpy(block, &self, sizeof(self));
+            char* start = block + header_size;
+            for (std::size_t i = slots_per_block; i-- > 0; )
+            {
+                char* slot = start + i * slot_size;
+                std::memcpy(slot, &free_list, sizeof(char*));
+                free_list = slot;
+            }
+        }
+    };
+
+    // Caches of exited threads, waiting to be adopted.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<ThreadCache*> orphans;
+    };
+
+    static Registry& registry()
+    {
+        static Registry* r = new Registry; // leaked, see class comment
+        return *r;
+    }
+
+    // Owns the calling thread's cache for the lifetime of the thread.
+    struct LocalCache
+    {
+        ThreadCache* cache;
+
+        LocalCache()
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            if (r.orphans.empty())
+                cache = new ThreadCache;
+            else
+            {
+                cache = r.orphans.back();
+                r.orphans.pop_back();
+            }
+        }
+
+        ~LocalCache()
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.orphans.push_back(cache);
+        }
+    };
+
+    static ThreadCache& local_cache()
+    {
+        static thread_local LocalCache local;
+        return *local.cache;
+    }
+
+    static ThreadCache* owner_of(void* p)
+    {
+        std::uintptr_t block = reinterpret_cast<std::uintptr_t>(p) & ~(std::uintptr_t)(BlockSize - 1);
+        ThreadCache* owner;
+        std::memcpy(&owner, reinterpret_cast<void*>(block), sizeof(owner));
+        return owner;
+    }
+
+public:
+    thread_caching_allocator() = default;
+
+    template <class U>
+    thread_caching_allocator(const thread_caching_allocator<U, BlockSize>&) {}
+
+    pointer allocate(size_type n)
+    {
+        if (n != 1)
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        ThreadCache& cache = local_cache();
+        if (!cache.free_list)
+            cache.refill();
+        char* slot = cache.free_list;
+        std::memcpy(&cache.free_list, slot, sizeof(char*));
+        return reinterpret_cast<pointer>(slot);
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (n != 1)
+        {
+            ::operator delete(p);
+            return;
+        }
+        char* slot = reinterpret_cast<char*>(p);
+        ThreadCache* owner = owner_of(slot);
+        ThreadCache& cache = local_cache();
+        if (owner == &cache)
+        {
+            std::memcpy(slot, &cache.free_list, sizeof(char*));
+            cache.free_list = slot;
+            return;
+        }
+        char* head = owner->remote_free.load(std::memory_order_relaxed);
+        do
+            std::memcpy(slot, &head, sizeof(char*));
+        while (!owner->remote_free.compare_exchange_weak(head, slot,
+                   std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+
+    bool operator==(const thread_caching_allocator&) const
+    {
+        return true;
+    }
+
+    bool operator!=(const thread_caching_allocator&) const
+    {
+        return false;
+    }
+};
+
+#endif /* THREAD_CACHING_ALLOCATOR_H_ */